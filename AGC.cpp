@@ -0,0 +1,90 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Development of this audio library was funded by PJRC.COM, LLC by sales of
+ * Teensy and Audio Adaptor boards.  Please support PJRC's efforts to develop
+ * open source software by purchasing Teensy or other PJRC products.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <Arduino.h>
+#include "AGC.h"
+#include "utility/dspinst.h"
+
+#define BLOCK_MS ( 1000.0 * AUDIO_BLOCK_SAMPLES / AUDIO_SAMPLE_RATE_EXACT )
+
+// one pole coefficient for a time constant in ms, Q15, updated once per block
+static int32_t agc_coeff( int ms ){
+float blocks;
+
+   blocks = (float)ms / BLOCK_MS;
+   if( blocks < 1.0 ) return 32767;
+   return 32767.0 * ( 1.0 - expf( -1.0 / blocks ));
+}
+
+void AudioAGC1::attack( int ms ){ k_attack = agc_coeff( ms ); }
+void AudioAGC1::decay( int ms ){ k_decay = agc_coeff( ms ); }
+void AudioAGC1::hang( int ms ){ hang_blocks = ms / BLOCK_MS; }
+
+void AudioAGC1::update(void){
+DSP_TIMER( cycles );
+audio_block_t *blk;
+int16_t *dat;
+int32_t peak, g, g1, step, val;
+int i;
+
+   blk = receiveWritable(0);
+   if( blk == 0 ) return;
+
+   // envelope from the new block
+   dat = blk->data;
+   peak = 0;
+   for( i = 0; i < AUDIO_BLOCK_SAMPLES; ++i ){
+      val = abs( dat[i] );
+      if( val > peak ) peak = val;
+   }
+   if( peak >= env ){
+      env += ( ( peak - env ) * k_attack ) >> 15;
+      if( env < peak && k_attack == 32767 ) env = peak;
+      hang_count = hang_blocks;
+   }
+   else if( hang_count ) --hang_count;
+   else env -= ( ( env - peak ) * k_decay ) >> 15;
+
+   // gain to bring the envelope to the target level, one divide per block
+   g1 = ( env > target ) ? ( target << 16 ) / env : max_gain;
+   if( g1 > max_gain ) g1 = max_gain;
+
+   // the held block is output with the gain ramping from the last value to the new one
+   if( held ){
+      g = gain;
+      step = ( g1 - g ) / AUDIO_BLOCK_SAMPLES;
+      dat = held->data;
+      for( i = 0; i < AUDIO_BLOCK_SAMPLES; ++i ){
+         val = signed_multiply_32x16b( g, dat[i] );          // ( g * x ) >> 16
+         dat[i] = signed_saturate_rshift( val, 16, 0 );
+         g += step;
+      }
+      transmit( held );
+      release( held );
+   }
+   gain = g1;
+   held = blk;                                               // output next time
+}
@@ -0,0 +1,88 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Development of this audio library was funded by PJRC.COM, LLC by sales of
+ * Teensy and Audio Adaptor boards.  Please support PJRC's efforts to develop
+ * open source software by purchasing Teensy or other PJRC products.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Receive AGC, replaces agc_process() in loop.  The envelope is the peak of each block, tracked with attack, hang
+// and decay times in ms.  The output is delayed one block so the gain can move down before a fast rising signal
+// gets to the output.  Gain is Q16 and ramps across the block to avoid clicks.
+
+#ifndef AGC_h_
+#define AGC_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+#include "DspCycles.h"
+
+class AudioAGC1 : public AudioStream
+{
+
+public:
+	AudioAGC1(void) : AudioStream(1, inputQueueArray) {
+	  held = 0;
+	  env = 0;
+	  gain = 65536;
+	  hang_count = 0;
+	  target = 4000;
+	  max_gain = 65536;
+	  attack( 2 ), decay( 300 ), hang( 500 );
+	}
+	virtual void update(void);
+	struct DSP_CYCLES cycles;            // of update(), DWT cycles
+
+  void attack( int ms );               // envelope rise time constant
+  void decay( int ms );                // envelope fall time constant after the hang time
+  void hang( int ms );                 // hold the envelope after a peak
+
+  void level( int peak ){              // output peak level to hold, full scale is 32767
+    target = peak;
+  }
+
+  void maxgain( float g ){             // gain when the signal is under the target level
+    max_gain = g * 65536.0;
+  }
+
+  int32_t envelope(){                  // input peak envelope, for the S meter
+    return env;
+  }
+
+  int32_t read_gain(){                 // Q16
+    return gain;
+  }
+
+private:
+  audio_block_t *inputQueueArray[1];
+  audio_block_t *held;                 // look ahead, the block being output
+  volatile int32_t env;
+  volatile int32_t gain;
+  int32_t target;
+  int32_t max_gain;
+  int32_t k_attack;                    // Q15 coefficients per block
+  int32_t k_decay;
+  int hang_blocks;
+  int hang_count;
+};
+
+
+#endif
@@ -0,0 +1,83 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Development of this audio library was funded by PJRC.COM, LLC by sales of
+ * Teensy and Audio Adaptor boards.  Please support PJRC's efforts to develop
+ * open source software by purchasing Teensy or other PJRC products.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <Arduino.h>
+#include "CWDet.h"
+#include "utility/dspinst.h"
+
+void AudioCWDet1::frequency( float hz ){
+float w;
+
+   w = 2.0 * PI * hz / AUDIO_SAMPLE_RATE_EXACT;
+   coeff = 2.0 * cosf( w ) * 1073741824.0;          // also cos(w) in Q31
+   sinw = sinf( w ) * 2147483647.0;
+}
+
+// integer square root, saturates at 2^17 - 1, above the 16 bit clamp
+static inline uint32_t cwd_sqrt( uint64_t p ){
+uint32_t r, t, bit;
+
+   r = 0;
+   for( bit = 1 << 16; bit; bit >>= 1 ){
+      t = r | bit;
+      if( (uint64_t)t * t <= p ) r = t;
+   }
+   return r;
+}
+
+void AudioCWDet1::update(void){
+DSP_TIMER( cycles );
+audio_block_t *blk;
+int32_t s0, s1, s2, re, im;
+uint32_t e;
+uint8_t h;
+int i;
+
+   blk = receiveReadOnly(0);
+   if( blk == 0 ) return;
+
+   s1 = s2 = 0;
+   for( i = 0; i < AUDIO_BLOCK_SAMPLES; ++i ){       // s grows to about 128 * 32767 / ( 2 sin(w) ), fits 32 bits
+      s0 = blk->data[i] + ( multiply_32x32_rshift32_rounded( coeff, s1 ) << 2 ) - s2;
+      s2 = s1;
+      s1 = s0;
+   }
+   release( blk );
+
+   re = s1 - ( multiply_32x32_rshift32_rounded( coeff, s2 ) << 1 );    // one bin DFT from the last two states
+   im = multiply_32x32_rshift32_rounded( sinw, s2 ) << 1;
+   re >>= 6;                                          // scale by 2 / AUDIO_BLOCK_SAMPLES before the square
+   im >>= 6;
+   e = cwd_sqrt( (int64_t)re * re + (int64_t)im * im );
+
+   h = ( head + 1 ) & ( CWD_RING - 1 );
+   if( h == tail ){
+      ++overruns;
+      return;
+   }
+   env[head] = ( e > 65535 ) ? 65535 : e;
+   head = h;
+}
@@ -0,0 +1,75 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Development of this audio library was funded by PJRC.COM, LLC by sales of
+ * Teensy and Audio Adaptor boards.  Please support PJRC's efforts to develop
+ * open source software by purchasing Teensy or other PJRC products.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// CW tone envelope at audio block resolution.  A fixed point Goertzel over each 128 sample block, 2.9ms, gives one
+// envelope value per block.  The values go in a ring that the decoder in loop reads, so the decoder sees every
+// block even when loop is slow.  Replaces AudioAnalyzeToneDetect, which took 10ms per result and returned a float.
+
+#ifndef CWDet_h_
+#define CWDet_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+#include "DspCycles.h"
+
+#define CWD_RING 32                   // blocks, about 93ms of envelope.  Power of 2.
+
+class AudioCWDet1 : public AudioStream
+{
+
+public:
+	AudioCWDet1(void) : AudioStream(1, inputQueueArray) {
+	  head = tail = 0;
+	  overruns = 0;
+	  frequency( 700 );
+	}
+	
+	virtual void update(void);
+	struct DSP_CYCLES cycles;            // of update(), DWT cycles
+
+  void frequency( float hz );
+
+  int available(){ return ( head - tail ) & ( CWD_RING - 1 ); }
+
+  uint16_t read(){                    // oldest envelope value, amplitude of the tone in the block
+    uint16_t e;
+    if( tail == head ) return 0;
+    e = env[tail];
+    tail = ( tail + 1 ) & ( CWD_RING - 1 );
+    return e;
+  }
+
+  volatile uint16_t overruns;
+
+private:
+  int32_t coeff;                      // 2 cos(w), Q30
+  int32_t sinw;                       // Q31
+  volatile uint8_t head, tail;
+  uint16_t env[CWD_RING];
+  audio_block_t *inputQueueArray[1];
+};
+
+#endif
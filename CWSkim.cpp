@@ -0,0 +1,88 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Development of this audio library was funded by PJRC.COM, LLC by sales of
+ * Teensy and Audio Adaptor boards.  Please support PJRC's efforts to develop
+ * open source software by purchasing Teensy or other PJRC products.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <Arduino.h>
+#include "CWSkim.h"
+#include "utility/dspinst.h"
+
+extern "C" {
+extern const int16_t AudioWindowHanning256[];
+}
+
+// magnitude estimate, max or 7/8 max + 1/2 min, same as fastAM2 in MagPhase
+static inline int32_t skim_mag( int32_t i, int32_t q ){
+int32_t mx, mn;
+
+   i = abs(i), q = abs(q);
+   if( i > q ) mx = i, mn = q;
+   else mx = q, mn = i;
+   if( mn <= ( mx >> 2 ) ) return mx;
+   return mx - ( mx >> 3 ) + ( mn >> 1 );
+}
+
+void AudioCWSkim1::update(void){
+DSP_TIMER( cycles );
+audio_block_t *blk;
+int32_t sum, val;
+int i, j;
+uint8_t h;
+
+   blk = receiveReadOnly(0);
+   if( blk == 0 ) return;
+   if( mode == 0 ){
+      release( blk );
+      return;
+   }
+
+   for( i = 0; i < AUDIO_BLOCK_SAMPLES; i += SKIM_DECI ){    // sum of 8, the gain of 8 helps the weak signals
+      sum = 0;
+      for( j = 0; j < SKIM_DECI; ++j ) sum += blk->data[i+j];
+      dec[fill++] = saturate16( sum );
+   }
+   release( blk );
+   if( fill < SKIM_FFT ) return;
+
+   for( i = 0; i < SKIM_FFT; ++i ){                  // every 4th point of the 256 hanning window
+      buffer[2*i] = ( dec[i] * AudioWindowHanning256[4*i] ) >> 15;
+      buffer[2*i+1] = 0;
+   }
+   for( i = 0; i < SKIM_FFT - SKIM_HOP; ++i ) dec[i] = dec[i + SKIM_HOP];
+   fill = SKIM_FFT - SKIM_HOP;
+
+   arm_cfft_radix4_q15( &fft_inst, buffer );
+
+   h = ( head + 1 ) & ( SKIM_FRAMES - 1 );
+   if( h == tail ){
+      ++overruns;
+      return;
+   }
+   for( i = 0; i < SKIM_CHANNELS; ++i ){
+      j = SKIM_BIN0 + i;
+      val = skim_mag( buffer[2*j], buffer[2*j+1] );
+      frames[head][i] = ( val > 65535 ) ? 65535 : val;
+   }
+   head = h;
+}
@@ -0,0 +1,91 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Development of this audio library was funded by PJRC.COM, LLC by sales of
+ * Teensy and Audio Adaptor boards.  Please support PJRC's efforts to develop
+ * open source software by purchasing Teensy or other PJRC products.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// CW skimmer front end.  The receive audio is decimated by 8 with a boxcar sum and a 64 point FFT is run every 48
+// decimated samples, 8.7ms.  Bins are 86 hz wide and SKIM_CHANNELS of them starting at SKIM_BIN0 are the channels.
+// One FFT per 3 audio blocks replaces a Goertzel filter per channel.  Each frame of channel magnitudes goes in a
+// ring for the mark space trackers and morse decoders that run in loop.
+
+#ifndef CWSkim_h_
+#define CWSkim_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+#include "DspCycles.h"
+#include "arm_math.h"
+
+#define SKIM_DECI      8
+#define SKIM_FFT      64
+#define SKIM_HOP      48              // 3 blocks of decimated samples
+#define SKIM_CHANNELS 16
+#define SKIM_BIN0      5              // 431 hz, last channel is 1723 hz
+#define SKIM_FRAMES    8              // ring of frames, power of 2
+#define SKIM_BIN_HZ   ( AUDIO_SAMPLE_RATE_EXACT / SKIM_DECI / SKIM_FFT )
+#define SKIM_FRAME_MS ( 1000.0 * SKIM_DECI * SKIM_HOP / AUDIO_SAMPLE_RATE_EXACT )
+
+class AudioCWSkim1 : public AudioStream
+{
+
+public:
+	AudioCWSkim1(void) : AudioStream(1, inputQueueArray) {
+	  arm_cfft_radix4_init_q15( &fft_inst, SKIM_FFT, 0, 1 );
+	  mode = fill = 0;
+	  head = tail = 0;
+	  overruns = 0;
+	}
+	
+	virtual void update(void);
+	struct DSP_CYCLES cycles;            // of update(), DWT cycles
+
+  void setmode( int m ){              // 0 off, 1 running
+    mode = m;
+    fill = 0;
+    tail = head;
+  }
+
+  int available(){ return ( head - tail ) & ( SKIM_FRAMES - 1 ); }
+
+  void read( uint16_t *mag ){         // SKIM_CHANNELS magnitudes of the oldest frame
+    int i;
+    if( tail == head ) return;
+    for( i = 0; i < SKIM_CHANNELS; ++i ) mag[i] = frames[tail][i];
+    tail = ( tail + 1 ) & ( SKIM_FRAMES - 1 );
+  }
+
+  volatile uint16_t overruns;         // loop did not read the frames in time
+
+private:
+  int mode;
+  int fill;                           // decimated samples in dec[]
+  volatile uint8_t head, tail;
+  audio_block_t *inputQueueArray[1];
+  arm_cfft_radix4_instance_q15 fft_inst;
+  int16_t dec[SKIM_FFT];
+  int16_t buffer[2*SKIM_FFT] __attribute__ ((aligned (4)));     // real and zero imaginary, FFT done in place
+  uint16_t frames[SKIM_FRAMES][SKIM_CHANNELS];
+};
+
+#endif
@@ -0,0 +1,91 @@
+// Decimate by 4 and interpolate by 4 for audio objects that work at 11029 hz.  One 64 tap Blackman windowed lowpass,
+// 5 khz at the 44117 rate, is used both ways.  Flat to 3.6k, the widest bandwidth, and 78 db down at 7.4k where the
+// first alias would fold back into 3.6k.  Whole blocks, 128 samples in to 32 out and back.
+// Only the kept outputs are computed on the way down, and on the way up each phase uses every 4th tap.  The sums run
+// two taps at a time through the Cortex-M4 dual 16 bit multiply, the results are the same as one tap at a time.
+
+#ifndef Decimate4_h_
+#define Decimate4_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+#include "utility/dspinst.h"
+#include "Hilbert31.h"
+
+#define DEC4_TAPS  64
+#define DEC4_OUT   ( AUDIO_BLOCK_SAMPLES / 4 )
+
+static constexpr int16_t dec4_taps[DEC4_TAPS] = {
+      0,     0,     1,     3,     4,     0,    -9,   -21,
+    -26,   -13,    22,    66,    93,    70,   -16,  -140,
+   -237,  -228,   -67,   215,   491,   582,   349,  -208,
+   -892, -1344, -1172,  -134,  1714,  3978,  6038,  7265,
+   7265,  6038,  3978,  1714,  -134, -1172, -1344,  -892,
+   -208,   349,   582,   491,   215,   -67,  -228,  -237,
+   -140,   -16,    70,    93,    66,    22,   -13,   -26,
+    -21,    -9,     0,     4,     3,     1,     0,     0
+};
+
+  // the same taps reversed and packed in pairs for the dual 16 bit multiply, see dual_mac() in Hilbert31.h.  Built
+  // from dec4_taps by the compiler.  dec is the decimator.  For each interpolation phase every 4th tap reversed, even
+  // for 16 samples that start on a word boundary, odd for 16 samples loaded from the word before with zero taps on
+  // the ends.
+struct DEC4_PACK {
+   uint32_t dec[DEC4_TAPS/2];
+   uint32_t even[4][DEC4_TAPS/8];
+   uint32_t odd[4][DEC4_TAPS/8 + 1];
+   static constexpr int16_t phase( int p, int j ){          // tap j of phase p reversed, 0 off the ends
+      return ( j < 0 || j >= DEC4_TAPS/4 ) ? 0 : dec4_taps[4 * ( DEC4_TAPS/4 - 1 - j ) + p];
+   }
+   constexpr DEC4_PACK() : dec(), even(), odd() {
+      for( int i = 0; i < DEC4_TAPS/2; ++i ) dec[i] = HKP( dec4_taps[DEC4_TAPS-1-2*i], dec4_taps[DEC4_TAPS-2-2*i] );
+      for( int p = 0; p < 4; ++p ){
+         for( int i = 0; i < DEC4_TAPS/8; ++i ) even[p][i] = HKP( phase( p, 2*i ), phase( p, 2*i+1 ) );
+         for( int i = 0; i < DEC4_TAPS/8 + 1; ++i ) odd[p][i] = HKP( phase( p, 2*i-1 ), phase( p, 2*i ) );
+      }
+   }
+};
+
+static constexpr DEC4_PACK dec4_pack;
+
+struct DECIM4 {                                             // one extra history sample keeps the sums word aligned
+   int16_t x[DEC4_TAPS + AUDIO_BLOCK_SAMPLES] __attribute__((aligned(4)));          // history then the new block
+};
+
+struct INTERP4 {
+   int16_t u[DEC4_TAPS/4 - 1 + DEC4_OUT] __attribute__((aligned(4)));               // history then the new samples
+};
+
+// AUDIO_BLOCK_SAMPLES in, DEC4_OUT out.  Output n is the filter at input sample 4n+3.
+static inline void decimate4( struct DECIM4 *d, const int16_t *in, int16_t *out ){
+int16_t *x;
+int32_t sum;
+int i;
+
+   x = d->x + DEC4_TAPS;
+   for( i = 0; i < AUDIO_BLOCK_SAMPLES; ++i ) x[i] = in[i];
+   for( i = 0; i < DEC4_OUT; ++i ){                          // taps over x[4i+3-63] to x[4i+3], always even
+      sum = dual_mac( d->x, 4*i + 4, dec4_pack.dec, dec4_pack.dec, DEC4_TAPS/2 );
+      out[i] = signed_saturate_rshift( sum, 16, 15 );
+   }
+   for( i = 0; i < DEC4_TAPS; ++i ) d->x[i] = d->x[i + AUDIO_BLOCK_SAMPLES];
+}
+
+// DEC4_OUT in, AUDIO_BLOCK_SAMPLES out.  Zero stuffed by 4, so the filter gain is made up with a shift of 13.
+static inline void interpolate4( struct INTERP4 *f, const int16_t *in, int16_t *out ){
+int16_t *u;
+int32_t sum;
+int m, p, j;
+
+   u = f->u + DEC4_TAPS/4 - 1;
+   for( m = 0; m < DEC4_OUT; ++m ) u[m] = in[m];
+   for( m = 0; m < DEC4_OUT; ++m ){                          // taps over u[m-15] to u[m]
+      for( p = 0; p < 4; ++p ){
+         sum = dual_mac( f->u, m, dec4_pack.even[p], dec4_pack.odd[p], DEC4_TAPS/8 );
+         *out++ = signed_saturate_rshift( sum, 16, 13 );
+      }
+   }
+   for( j = 0; j < DEC4_TAPS/4 - 1; ++j ) f->u[j] = f->u[j + DEC4_OUT];
+}
+
+#endif
@@ -0,0 +1,30 @@
+// Cycle count of an audio object update() from the DWT cycle counter, for DSP_BENCH and the #P CAT command.  The
+// library's own processorUsage() is a whole percent of the block time, about 2800 cycles, too coarse for the small
+// objects.  Declare a DSP_TIMER first thing in update(), it reads the counter on the way in and on every way out.
+
+#ifndef DspCycles_h_
+#define DspCycles_h_
+
+#include "Arduino.h"
+
+struct DSP_CYCLES {
+   volatile uint32_t now;              // last update()
+   volatile uint32_t max;              // worst case since reset
+};
+
+class DspTimer {
+public:
+   DspTimer( struct DSP_CYCLES *c ) : cyc( c ), start( ARM_DWT_CYCCNT ) {}
+   ~DspTimer(){
+      uint32_t t = ARM_DWT_CYCCNT - start;
+      cyc->now = t;
+      if( t > cyc->max ) cyc->max = t;
+   }
+private:
+   struct DSP_CYCLES *cyc;
+   uint32_t start;
+};
+
+#define DSP_TIMER( c )  DspTimer dsp_timer( &c )
+
+#endif
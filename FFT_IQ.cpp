@@ -0,0 +1,87 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Development of this audio library was funded by PJRC.COM, LLC by sales of
+ * Teensy and Audio Adaptor boards.  Please support PJRC's efforts to develop
+ * open source software by purchasing Teensy or other PJRC products.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <Arduino.h>
+#include "FFT_IQ.h"
+
+extern "C" {
+extern const int16_t AudioWindowHanning256[];
+}
+
+// magnitude estimate, max or 7/8 max + 1/2 min, same as fastAM2 in MagPhase
+static inline int32_t fft_mag( int32_t i, int32_t q ){
+int32_t mx, mn;
+
+   i = abs(i), q = abs(q);
+   if( i > q ) mx = i, mn = q;
+   else mx = q, mn = i;
+   if( mn <= ( mx >> 2 ) ) return mx;
+   return mx - ( mx >> 3 ) + ( mn >> 1 );
+}
+
+void AudioFFT_IQ1::update(void){
+DSP_TIMER( cycles );
+audio_block_t *blki, *blkq;
+int16_t *p;
+int32_t val;
+int i, n;
+
+   blki = receiveReadOnly(0);
+   blkq = receiveReadOnly(1);
+   if( mode == 0 || blki == 0 || blkq == 0 ){
+      if( blki ) release( blki );
+      if( blkq ) release( blkq );
+      half = frame = 0;
+      return;
+   }
+
+   if( frame == 0 ){                              // only keep the frames that will be transformed
+      n = half * AUDIO_BLOCK_SAMPLES;
+      p = buffer + 2 * n;
+      for( i = 0; i < AUDIO_BLOCK_SAMPLES; ++i, ++n ){
+         *p++ = ( blki->data[i] * AudioWindowHanning256[n] ) >> 15;
+         *p++ = ( blkq->data[i] * AudioWindowHanning256[n] ) >> 15;
+      }
+   }
+   release( blki );
+   release( blkq );
+
+   if( ++half < 2 ) return;
+   half = 0;
+   if( frame ){
+      if( ++frame >= rate ) frame = 0;
+      return;
+   }
+   if( rate > 1 ) frame = 1;
+
+   arm_cfft_radix4_q15( &fft_inst, buffer );
+
+   for( i = 0; i < 256; ++i ){
+      val = fft_mag( buffer[2*i], buffer[2*i+1] );
+      bins[i] = ( val > 65535 ) ? 65535 : val;
+   }
+   avail = 1;
+}
@@ -0,0 +1,86 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Development of this audio library was funded by PJRC.COM, LLC by sales of
+ * Teensy and Audio Adaptor boards.  Please support PJRC's efforts to develop
+ * open source software by purchasing Teensy or other PJRC products.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Band scope.  A 256 point complex FFT of the I and Q adc samples shows both sides of the vfo at once, 172 hz per bin.
+// Replaces the Goertzel filters that were moved around the band one bin at a time.
+// Bin 0 is the vfo frequency, bins 1 to 127 are above it and bins 255 down to 128 are below.
+
+#ifndef FFT_IQ_h_
+#define FFT_IQ_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+#include "DspCycles.h"
+#include "arm_math.h"
+
+class AudioFFT_IQ1 : public AudioStream
+{
+
+public:
+	AudioFFT_IQ1(void) : AudioStream(2, inputQueueArray) {
+	  arm_cfft_radix4_init_q15( &fft_inst, 256, 0, 1 );
+	  mode = avail = half = frame = 0;
+	  rate = 4;
+	}
+	
+	virtual void update(void);
+	struct DSP_CYCLES cycles;            // of update(), DWT cycles
+
+  void setmode( int m ){              // 0 off, 1 running
+    mode = m;
+    half = frame = 0;
+  }
+
+  void setrate( int r ){              // one FFT for every r frames of 256 samples.  4 is about 23ms per update
+    if( r < 1 ) r = 1;
+    rate = r;
+  }
+
+  int available(){
+    if( avail ){
+      avail = 0;
+      return 1;
+    }
+    return 0;
+  }
+
+  uint16_t read( int bin ){
+    return bins[bin & 255];
+  }
+
+private:
+  int mode;
+  int rate;
+  int avail;
+  int half;                           // which block of the 256 sample frame
+  int frame;                          // frames skipped since the last FFT
+  audio_block_t *inputQueueArray[2];
+  arm_cfft_radix4_instance_q15 fft_inst;
+  int16_t buffer[512] __attribute__ ((aligned (4)));     // interleaved I and Q, FFT done in place
+  uint16_t bins[256];
+};
+
+#endif
@@ -0,0 +1,69 @@
+// Biquad coefficients worked out by the compiler.  The same RBJ cookbook design as AudioFilterBiquad setLowpass and
+// setHighpass, but constexpr, so the tables are in flash and switching a filter is just a pointer change.  sin and cos
+// are series that are good to 1e-9 over the 0 to pi range used here.  Needs C++14 for the loops.
+
+#ifndef FilterBank_h_
+#define FilterBank_h_
+
+#include <stdint.h>
+
+#define FB_PI  3.14159265358979
+
+struct WV_COEF {
+   int32_t b0, b1, b2, a1, a2;                     // Q30, y = b0 x0 + b1 x1 + b2 x2 - a1 y1 - a2 y2
+};
+
+constexpr double fb_sin( double x ){
+double term = x, sum = x;
+
+   for( int n = 1; n < 12; ++n ){
+      term *= -x * x / ( ( 2 * n ) * ( 2 * n + 1 ));
+      sum += term;
+   }
+   return sum;
+}
+
+constexpr double fb_cos( double x ){
+double term = 1.0, sum = 1.0;
+
+   for( int n = 1; n < 12; ++n ){
+      term *= -x * x / ( ( 2 * n - 1 ) * ( 2 * n ));
+      sum += term;
+   }
+   return sum;
+}
+
+constexpr WV_COEF fb_biquad( double hz, double q, int high, double rate ){
+WV_COEF k = { 0, 0, 0, 0, 0 };
+double w0 = hz * ( 2.0 * FB_PI / rate );
+double cs = fb_cos( w0 );
+double alpha = fb_sin( w0 ) / ( 2.0 * q );
+double scale = 1073741824.0 / ( 1.0 + alpha );
+
+   if( high ){
+      k.b0 = ( ( 1.0 + cs ) / 2.0 ) * scale;
+      k.b1 = -( 1.0 + cs ) * scale;
+   }
+   else{
+      k.b0 = ( ( 1.0 - cs ) / 2.0 ) * scale;
+      k.b1 = ( 1.0 - cs ) * scale;
+   }
+   k.b2 = k.b0;
+   k.a1 = ( -2.0 * cs ) * scale;
+   k.a2 = ( 1.0 - alpha ) * scale;
+   return k;
+}
+
+// AudioFilterBiquad::setCoefficients( stage, const int * ) order.  Copied as is, setCoefficients negates a1 and a2
+// itself, the same as for the setLowpass() values.
+struct FB_TEENSY {
+   int k[4][5];
+   constexpr FB_TEENSY( const WV_COEF *s ) : k() {
+      for( int i = 0; i < 4; ++i ){
+         k[i][0] = s[i].b0;   k[i][1] = s[i].b1;   k[i][2] = s[i].b2;
+         k[i][3] = s[i].a1;   k[i][4] = s[i].a2;
+      }
+   }
+};
+
+#endif
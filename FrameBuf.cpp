@@ -0,0 +1,181 @@
+// Framebuffer for the OLED and LCD displays.  The print functions follow the Rinky-Dink Electronics LCD5110 library
+// that both display libraries are based on.
+
+#include <Arduino.h>
+#include "FrameBuf.h"
+
+void FrameBuf::begin( void (*out_fun)( int row, int col, uint8_t *dat, int n ) ){
+int row;
+
+   out = out_fun;
+   for( row = 0; row < pages; ++row ){          // the screen contents are unknown, send it all the first time
+      memset( buf[row], 0, width );
+      dirty_lo[row] = 0;
+      dirty_hi[row] = width - 1;
+   }
+}
+
+void FrameBuf::put( int row, int col, uint8_t dat ){
+
+   if( row >= pages || col >= width ) return;
+   if( buf[row][col] == dat ) return;
+   buf[row][col] = dat;
+   if( col < dirty_lo[row] ) dirty_lo[row] = col;
+   if( col > dirty_hi[row] ) dirty_hi[row] = col;
+}
+
+int FrameBuf::dirty(){
+int row;
+
+   for( row = 0; row < pages; ++row ) if( dirty_lo[row] <= dirty_hi[row] ) return 1;
+   return 0;
+}
+
+// send the next dirty range, up to max_bytes of it.  Pages are taken in turn so a busy scope doesn't hold off the rest.
+int FrameBuf::flush( int max_bytes ){
+int i, row, lo, n;
+
+   if( out == 0 ) return 0;
+   for( i = 0; i < pages; ++i ){
+      row = ( next_row + i ) % pages;
+      if( dirty_lo[row] > dirty_hi[row] ) continue;
+      lo = dirty_lo[row];
+      n = dirty_hi[row] - lo + 1;
+      if( n > max_bytes ) n = max_bytes;
+      dirty_lo[row] += n;
+      if( dirty_lo[row] > dirty_hi[row] ) dirty_lo[row] = width, dirty_hi[row] = -1;
+      out( row, lo, &buf[row][lo], n );
+      next_row = row + 1;
+      return n;
+   }
+   return 0;
+}
+
+void FrameBuf::flush_all(){
+
+   while( flush() );
+}
+
+void FrameBuf::clrScr(){
+int row;
+
+   for( row = 0; row < pages; ++row ) clrRow( row );
+}
+
+void FrameBuf::clrRow( int row, int start_x, int end_x ){
+int col;
+
+   if( end_x >= width ) end_x = width - 1;
+   for( col = start_x; col <= end_x; ++col ) put( row, col, 0 );
+}
+
+// position for write, putch and puts.  Writes wrap to the next row like the display auto increment.
+void FrameBuf::gotoRowCol( int row, int col ){
+
+   cur_row = row;
+   cur_col = col;
+}
+
+void FrameBuf::write( unsigned char dat, int count ){
+
+   while( count-- ){
+      put( cur_row, cur_col, dat );
+      if( ++cur_col >= width ) cur_col = 0, ++cur_row;
+   }
+}
+
+void FrameBuf::putch( char dat ){
+
+   draw_char( dat, cur_col, cur_row );
+   cur_col += x_size;
+}
+
+void FrameBuf::puts( char *p ){
+char c;
+
+   while( ( c = *p++ ) ) putch(c);
+}
+
+void FrameBuf::setFont( uint8_t *f ){
+
+   font = f;
+   x_size = f[0];
+   y_size = f[1];
+   offset = f[2];
+   inverted = 0;
+}
+
+void FrameBuf::draw_char( unsigned char c, int x, int row ){
+int i, r, idx;
+uint8_t dat;
+
+   if( font == 0 ) return;
+   idx = ( c - offset ) * ( x_size * ( y_size / 8 )) + 4;
+   for( r = 0; r < y_size / 8; ++r ){
+      for( i = 0; i < x_size; ++i ){
+         dat = font[idx + i + r * x_size];
+         if( inverted ) dat = ~dat;
+         put( row + r, x + i, dat );
+      }
+   }
+}
+
+void FrameBuf::print( char *st, int x, int y ){
+int len, i;
+
+   len = strlen( st );
+   if( x == RIGHT ) x = width - len * x_size;
+   if( x == CENTER ) x = ( width - len * x_size ) / 2;
+   if( x < 0 ) x = 0;
+   for( i = 0; i < len; ++i ) draw_char( st[i], x + i * x_size, y / 8 );
+   cur_row = y / 8;
+   cur_col = x + len * x_size;
+}
+
+void FrameBuf::print( String st, int x, int y ){
+char b[st.length() + 1];
+
+   st.toCharArray( b, st.length() + 1 );
+   print( b, x, y );
+}
+
+void FrameBuf::printNumI( long num, int x, int y, int length, char filler ){
+char b[27];
+char st[27];
+int n, i, neg;
+
+   neg = ( num < 0 );
+   if( neg ) num = -num;
+   n = 0;
+   do{                                           // digits in reverse
+      b[n++] = '0' + num % 10;
+      num /= 10;
+   }while( num && n < 20 );
+
+   i = 0;
+   if( neg ) st[i++] = '-';
+   while( i + n < length ) st[i++] = filler;
+   while( n ) st[i++] = b[--n];
+   st[i] = 0;
+   print( st, x, y );
+}
+
+void FrameBuf::printNumF( double num, byte dec, int x, int y, char divider, int length, char filler ){
+char st[27];
+char format[10];
+unsigned int i;
+
+   sprintf( format, "%%%i.%if", length, dec );
+   snprintf( st, sizeof(st), format, num );
+   if( divider != '.' ){
+      for( i = 0; i < strlen(st); ++i ) if( st[i] == '.' ) st[i] = divider;
+   }
+   if( filler != ' ' ){
+      for( i = 0; i < strlen(st); ++i ) if( st[i] == ' ' ) st[i] = filler;
+      if( num < 0 && st[0] != '-' ){            // move the sign to the front like the library
+         for( i = 0; i < strlen(st); ++i ) if( st[i] == '-' ) st[i] = filler;
+         st[0] = '-';
+      }
+   }
+   print( st, x, y );
+}
@@ -0,0 +1,70 @@
+// Off screen copy of the OLED or LCD display.  Same print functions as the OLED1306 and LCD5110 libraries, but they only
+// write to memory.  Bytes that change mark a dirty column range for their page, and flush() sends one dirty range per
+// call as a single burst.  Call flush() from loop, it never blocks for the whole screen.
+
+#ifndef FrameBuf_h_
+#define FrameBuf_h_
+
+#include "Arduino.h"
+
+#ifndef LEFT
+ #define LEFT 0
+ #define RIGHT 9999
+ #define CENTER 9998
+#endif
+
+#define FB_MAX_COLS 128
+#define FB_MAX_ROWS 8
+
+class FrameBuf
+{
+
+public:
+  FrameBuf( int cols, int rows ){
+    width = cols;
+    pages = rows;
+    cur_row = cur_col = 0;
+    inverted = 0;
+    font = 0;
+    out = 0;
+    next_row = 0;
+    for( int i = 0; i < FB_MAX_ROWS; ++i ) dirty_lo[i] = FB_MAX_COLS, dirty_hi[i] = -1;
+  }
+
+  // out sends n bytes to the display starting at row, col
+  void begin( void (*out_fun)( int row, int col, uint8_t *dat, int n ) );
+  int  flush( int max_bytes = FB_MAX_COLS );     // send some dirty bytes, returns the number sent
+  void flush_all();
+  int  dirty();                                  // true if anything is waiting to be sent
+
+  void clrScr();
+  void clrRow( int row, int start_x = 0, int end_x = 9999 );
+  void gotoRowCol( int row, int col );
+  void write( unsigned char dat, int count = 1 );
+  void putch( char dat );
+  void puts( char *p );
+  void invertText( bool mode ){ inverted = mode; }
+  void print( char *st, int x, int y );
+  void print( String st, int x, int y );
+  void printNumI( long num, int x, int y, int length = 0, char filler = ' ' );
+  void printNumF( double num, byte dec, int x, int y, char divider = '.', int length = 0, char filler = ' ' );
+  void setFont( uint8_t *f );
+
+private:
+  int width;
+  int pages;
+  int cur_row, cur_col;
+  int next_row;                                  // flush takes the pages in turn
+  int inverted;
+  uint8_t *font;
+  uint8_t x_size, y_size, offset;
+  void (*out)( int row, int col, uint8_t *dat, int n );
+  uint8_t buf[FB_MAX_ROWS][FB_MAX_COLS];
+  int16_t dirty_lo[FB_MAX_ROWS];                 // dirty column range of each page, lo > hi when clean
+  int16_t dirty_hi[FB_MAX_ROWS];
+
+  void put( int row, int col, uint8_t dat );
+  void draw_char( unsigned char c, int x, int row );
+};
+
+#endif
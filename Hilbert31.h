@@ -0,0 +1,84 @@
+// A 31 tap classic hilbert, every other constant is zero, Kaiser window.  Used by MagPhase.
+// Block version.  The delay line is a linear array of 30 history samples followed by the new samples, so the history
+// is moved once per block instead of shifting 30 terms for every sample.  As the odd taps are zero, an output only uses
+// the 16 samples of one parity.  The samples are split into even and odd arrays so adjacent pairs can be run through
+// the Cortex-M4 dual 16 bit multiply.
+
+#ifndef Hilbert31_h_
+#define Hilbert31_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+#include "utility/dspinst.h"
+
+#define HILBERT_HIST 30                       // history samples needed by 31 taps, center tap delay is half of this
+
+#define HK0  ( 32767.5 * 0.002972769320862211 )
+#define HK1  ( 32767.5 * 0.008171666650726522 )
+#define HK2  ( 32767.5 * 0.017465643081957562 )
+#define HK3  ( 32767.5 * 0.032878923709314147 )
+#define HK4  ( 32767.5 * 0.058021930268698417 )
+#define HK5  ( 32767.5 * 0.101629404192315698 )
+#define HK6  ( 32767.5 * 0.195583262432201366 )
+#define HK7  ( 32767.5 * 0.629544595185021816 )
+
+  // pack two 16 bit taps into one word, first tap in the bottom half to match the sample order in memory
+#define HKP(a,b)  ( (uint32_t)(uint16_t)(int16_t)(a) | ((uint32_t)(uint16_t)(int16_t)(b) << 16) )
+
+  // taps for 16 samples that start on a word boundary
+static const uint32_t hilbert_even[8] = {
+  HKP( HK0, HK1), HKP( HK2, HK3), HKP( HK4, HK5), HKP( HK6, HK7),
+  HKP(-HK7,-HK6), HKP(-HK5,-HK4), HKP(-HK3,-HK2), HKP(-HK1,-HK0)
+};
+
+  // taps for 16 samples that start one past a word boundary, loaded from the word before with zero taps on the ends
+static const uint32_t hilbert_odd[9] = {
+  HKP(   0, HK0), HKP( HK1, HK2), HKP( HK3, HK4), HKP( HK5, HK6), HKP( HK7,-HK7),
+  HKP(-HK6,-HK5), HKP(-HK4,-HK3), HKP(-HK2,-HK1), HKP(-HK0,   0)
+};
+
+struct HILBERT31 {
+   int16_t x[HILBERT_HIST + AUDIO_BLOCK_SAMPLES];                                   // history then new samples
+   int16_t ev[(HILBERT_HIST + AUDIO_BLOCK_SAMPLES)/2 + 2] __attribute__((aligned(4)));  // even samples of x
+   int16_t od[(HILBERT_HIST + AUDIO_BLOCK_SAMPLES)/2 + 2] __attribute__((aligned(4)));  // odd samples of x
+};
+
+
+// sum of samples x[n] onward times packed taps.  x must be word aligned.  When n is odd the words are loaded from
+// x[n-1] and the odd tap table is used, it has one more word than the even table.
+static inline int32_t dual_mac( const int16_t *x, int n, const uint32_t *k_even, const uint32_t *k_odd, int words ){
+const uint32_t *p;
+const uint32_t *k;
+int32_t sum;
+
+   if( n & 1 ) p = (const uint32_t *)( x + n - 1 ), k = k_odd, ++words;
+   else p = (const uint32_t *)( x + n ), k = k_even;
+
+   sum = 0;
+   while( words-- ) sum += multiply_16tx16t_add_16bx16b( *p++, *k++ );
+   return sum;
+}
+
+
+// n new samples have been placed at h->x + HILBERT_HIST.  out gets the hilbert result, and dly if not null gets the
+// input delayed by the center tap to stay in phase with it.
+static inline void hilbert31( struct HILBERT31 *h, int n, int32_t *out, int32_t *dly ){
+int16_t *x;
+int i;
+
+   x = h->x;
+   for( i = 0; i < ( HILBERT_HIST + n + 1 )/2; ++i ){       // split into even and odd samples
+      h->ev[i] = x[2*i];
+      h->od[i] = x[2*i+1];
+   }
+
+   for( i = 0; i < n; ++i ){                                 // output i uses x[i] to x[i+30], step 2
+      if( i & 1 ) out[i] = dual_mac( h->od, i >> 1, hilbert_even, hilbert_odd, 8 ) >> 15;
+      else        out[i] = dual_mac( h->ev, i >> 1, hilbert_even, hilbert_odd, 8 ) >> 15;
+      if( dly ) dly[i] = x[HILBERT_HIST/2 + i];
+   }
+
+   for( i = 0; i < HILBERT_HIST; ++i ) x[i] = x[n+i];        // save history for the next block
+}
+
+#endif
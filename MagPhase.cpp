@@ -26,17 +26,47 @@
 
 // find the magnitude and phase of the transmit audio I and Q streams
 // it seems the general idea here is conversion from XY cartesian to polar form
-// decimate by N version
+// decimate by N version, N of 4, 5 or 6 selected with setrate()
+// The 36 tap transmit lowpass ( was the TXLow object ) runs here as a polyphase decimator, only the outputs that are kept
+// are calculated.
 
-#define DRATE 6              // decimation rate.  Input should be lowpass filtered appropriately.
 #define DC_OFFSET 0          // try a tx feature from the rx improved branch ( it reduces the suppression of the carrier )
+#ifndef MP_CORDIC
+#define MP_CORDIC 12         // cordic steps for phase and magnitude, 8 to 16.  0 uses arctan3 and fastAM2.
+#endif
 
 #include <Arduino.h>
 #include "MagPhase.h"
 #include "utility/dspinst.h"
+#include "Hilbert31.h"
+#include "ParksLPF36.h"
 
+#define FIR_TAPS 36
+#define FIR_HIST (FIR_TAPS-1)
 
- static int32_t val1, val2;
+static struct HILBERT31 hil;        // block hilbert run on the decimated samples
+static int ua = 44117/6;            // phase units for one turn, same as the decimated sample rate
+
+static int16_t fx[FIR_HIST + AUDIO_BLOCK_SAMPLES + 1] __attribute__((aligned(4)));    // fir history then new samples
+static uint32_t fir_even[FIR_TAPS/2];                  // packed taps for dual_mac, reversed to match the sample order
+static uint32_t fir_odd[FIR_TAPS/2 + 1];
+
+static void fir_init(){
+int16_t k[FIR_TAPS + 2];
+int i;
+
+   k[0] = k[FIR_TAPS+1] = 0;                           // zero taps on the ends for the odd alignment
+   for( i = 0; i < FIR_TAPS; ++i ) k[i+1] = TXLowc[FIR_TAPS-1-i];
+   for( i = 0; i < FIR_TAPS/2; ++i ) fir_even[i] = HKP( k[2*i+1], k[2*i+2] );
+   for( i = 0; i < FIR_TAPS/2 + 1; ++i ) fir_odd[i] = HKP( k[2*i], k[2*i+1] );
+}
+
+int AudioMagPhase1::setrate( int r ){
+   rate = constrain( r, 4, 6 );
+   ua = 44117 / rate;
+   fill = 2 * AUDIO_BLOCK_SAMPLES / rate + 8;          // two blocks and some margin
+   return ua;
+}
 
 /* 
     //  approx magnitude of I and Q channels
@@ -57,6 +87,7 @@ static int32_t fastAM( int32_t i, int32_t q ){         // cpu 31-34
 }
 */
 
+#if MP_CORDIC == 0 || defined(CORDIC_BENCH)         // the old pair, test/cordic_bench.cpp compares against them
 static int32_t fastAM2( int32_t i, int32_t q ){             // this is quite a bit better   ref: [2]
 int32_t mb4;                                                // return max or 7/8 max + 1/2 min, cpu 34
 
@@ -83,7 +114,7 @@ int32_t mb4;                                                // return max or 7/8
 static int32_t arctan3( int32_t q, int32_t i ){           // from QCX-SSB code
 
 
-  #define _UA 44117/DRATE                                       // can use arbitrary number
+  #define _UA ua                                                // can use arbitrary number
   #define _atan2(z)  (((_UA/8 + _UA/22) - _UA/22 * z ) * z)     //uSDX original derived from equation 5 [1]. Perhaps smoother overall.
   //#define _atan2(z)  (((_UA/8 + _UA/23) - _UA/23 * z ) * z)    // derived from equation 7 [1]. Don't notice much difference in result.
   
@@ -96,6 +127,37 @@ static int32_t arctan3( int32_t q, int32_t i ){           // from QCX-SSB code
   r = (i < 0) ? _UA / 2 - r : r;                    // arctan(-z) = -arctan(z)
   return (q < 0) ? -r : r;                          // arctan(-z) = -arctan(z)
 }
+#endif
+
+#if MP_CORDIC
+// atan( 2^-i ) in binary angle units, 2^32 for one turn
+static const int32_t cordic_atan[16] = {
+  536870912, 316933406, 167458907, 85004756, 42667331, 21354465, 10679838, 5340245,
+  2670163, 1335087, 667544, 333772, 166886, 83443, 41722, 20861
+};
+
+// vectoring cordic, rotate q,i onto the x axis.  Phase is the sum of the rotations and magnitude is what is left in x.
+// Shift and add only, no divide.  Each step adds about one bit to the phase.
+static int32_t cordic( int32_t q, int32_t i, int32_t *mag ){
+int32_t x, y, t;
+int32_t ang;
+int k;
+
+  x = i << 12;                         // 16 bit inputs, room for the cordic gain of 1.65 * sqrt(2)
+  y = q << 12;
+  ang = 0;
+  if( x < 0 ) x = -x, y = -y, ang = 0x80000000;     // rotate 180 into the right half plane
+
+  for( k = 0; k < MP_CORDIC; ++k ){
+     t = x;
+     if( y > 0 ) x += y >> k, y -= t >> k, ang += cordic_atan[k];
+     else        x -= y >> k, y += t >> k, ang -= cordic_atan[k];
+  }
+
+  *mag = multiply_32x32_rshift32( x, 1304065748 ) >> 11;           // remove the cordic gain, 0.60725 * 2^31
+  return ( (int64_t)ang * ua + 0x80000000LL ) >> 32;               // scale to +- ua/2 like arctan3, rounded
+}
+#endif
 
 /*
 // a 31 tap +45 -45 Hilbert calculated in parallel using 1 set of constants.  Increases cpu 34 to 42. The idea works fine.
@@ -150,37 +212,18 @@ int i;
 }
 */ 
 
-// a 31 tap classic hilbert every other constant is zero, kaiser window
-static void process_hilbert( int16_t val ){
-static int32_t wi[31];                                // delay terms
-// static int32_t wq[31];                             // extra redundant array
-const int32_t k0 = (int32_t)( 32767.5 * 0.002972769320862211 );
-const int32_t k1 = (int32_t)( 32767.5 * 0.008171666650726522 );
-const int32_t k2 = (int32_t)( 32767.5 * 0.017465643081957562 );
-const int32_t k3 = (int32_t)( 32767.5 * 0.032878923709314147 );
-const int32_t k4 = (int32_t)( 32767.5 * 0.058021930268698417 );
-const int32_t k5 = (int32_t)( 32767.5 * 0.101629404192315698 );
-const int32_t k6 = (int32_t)( 32767.5 * 0.195583262432201366 );
-const int32_t k7 = (int32_t)( 32767.5 * 0.629544595185021816 );
-
-   for( int i = 0; i < 30; ++i )  wi[i] = wi[i+1];      //,  wq[i] = wq[i+1];
-   // wi[30] = wq[30] = val;
-   wi[30] = val;
-
-   val2 = wi[15];          // wq[15];
-   val1 =  k0 * ( wi[0] - wi[30] ) + k1 * ( wi[2] - wi[28] ) + k2 * ( wi[4] - wi[26] ) + k3 * ( wi[6] - wi[24] );
-   val1 += k4 * ( wi[8] - wi[22] ) + k5 * ( wi[10] - wi[20]) + k6 * ( wi[12] - wi[18]) + k7 * ( wi[14] - wi[16]);
-   val1 >>= 15;
-
-}
-
-
 void AudioMagPhase1::update(void){ 
 
+    DSP_TIMER( cycles );
     audio_block_t *blk1;
     int16_t *dat1;
-    int i;
+    int i, n, h, nh;
+    int32_t m, p;
     static int rem;                  // 128 by 6 has a remainder when done
+    static int init;
+    int16_t dec[AUDIO_BLOCK_SAMPLES/4 + 1];          // decimated samples of this block
+    static int32_t val1[AUDIO_BLOCK_SAMPLES/4 + 1];  // hilbert and delayed audio
+    static int32_t val2[AUDIO_BLOCK_SAMPLES/4 + 1];
 
     // receiving, do nothing
     if( mode == 0 ){
@@ -196,32 +239,51 @@ void AudioMagPhase1::update(void){
        return;
     }
     
-    // decimate by DRATE, 6-> sample rate 7353, input must be lowpassed < 3.5k
+    if( init == 0 ) fir_init(), init = 1;
+
+    // lowpass and decimate by rate, 6-> sample rate 7353.  Output i uses fx[i] to fx[i+35].
     dat1 = blk1->data;
-    
+    for( i = 0; i < AUDIO_BLOCK_SAMPLES; i++ ) fx[FIR_HIST + i] = dat1[i];
+    n = 0;
     for( i = 0; i < AUDIO_BLOCK_SAMPLES; i++ ){
-
         ++rem;
-        if( rem == DRATE ){
+        if( rem >= rate ){
            rem = 0;  
+           dec[n++] = signed_saturate_rshift( dual_mac( fx, i, fir_even, fir_odd, FIR_TAPS/2 ), 16, 15 );
+        }
+    }
+    for( i = 0; i < FIR_HIST; ++i ) fx[i] = fx[AUDIO_BLOCK_SAMPLES + i];
 
-           if( mode == 1 ){                                       // SSB DATA mode
-              process_hilbert( *dat1 + DC_OFFSET );               // get val1 and val2            
-              mag[count] = fastAM2( val1, val2);
-              ph[count]  =  arctan3( val1, val2 );
-           }
-           else{                                                  // AM DSB modes
-              mag[count] = *dat1;                                 // save just the plain audio signal
-              ph[count] = 0;                                      // no phase changes
-           }
-           ++count;    count &=  (AUDIO_BLOCK_SAMPLES-1);     // assume power of two block size ( currently 128 )
+    if( mode == 1 ){                                              // SSB DATA mode
+       for( i = 0; i < n; ++i ) hil.x[HILBERT_HIST + i] = dec[i] + DC_OFFSET;
+       hilbert31( &hil, n, val1, val2 );                          // get val1 and val2 for the whole block
+    }
+
+    h = head;
+    for( i = 0; i < n; ++i ){
+        if( mode == 1 ){
+           #if MP_CORDIC
+              p = cordic( val1[i], val2[i], &m );
+           #else
+              m = fastAM2( val1[i], val2[i] );
+              p = arctan3( val1[i], val2[i] );
+           #endif
+        }
+        else{                                                     // AM DSB modes
+           m = dec[i];                                            // save just the plain audio signal
+           p = 0;                                                 // no phase changes
+        }
+        nh = ( h + 1 ) & ( AUDIO_BLOCK_SAMPLES - 1 );            // assume power of two block size ( currently 128 )
+        if( nh == tail ){
+           ++overruns;
+           continue;
         }
-        dat1 += 1;                                              
+        mag[h] = m;
+        ph[h] = p;
+        h = nh;
     }
-    if( count >= AUDIO_BLOCK_SAMPLES / 2 ) avail = 1;         // have buffered > 6ms of data, avail latches on
-    noInterrupts();
-    report_count = count;                                     // only report the block ending position of the count
-    interrupts();
+    head = h;                                                 // publish the block to the EER interrupt
+    if( level() >= fill ) avail = 1;                          // avail latches on
     release( blk1 );
 }
 
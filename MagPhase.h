@@ -29,46 +29,64 @@
 
 #include "Arduino.h"
 #include "AudioStream.h"
+#include "DspCycles.h"
 
 class AudioMagPhase1 : public AudioStream
 {
 
 public:
 	AudioMagPhase1(void) : AudioStream(1, inputQueueArray) {
-
+	  setrate( 6 );
 	}
 	
 	virtual void update(void);
+	struct DSP_CYCLES cycles;            // of update(), DWT cycles
+
+  int setrate( int r );                // decimation rate 4, 5 or 6. Returns the phase units per turn.
   
   void setmode( int m ){
     mode = m;
-    report_count = count = avail = 0;                  // reset all on mode change
+    head = tail = avail = 0;                          // reset all on mode change
+    underruns = overruns = 0;
   }
  
-  int available(){
+  int available(){                     // latches on when the ring first fills to the target level
     return avail; 
   }
 
-  int32_t mvalue( int i ){
-    return mag[i];
+  int level(){                         // samples waiting in the ring
+    return ( head - tail ) & ( AUDIO_BLOCK_SAMPLES - 1 );
   }
 
-  int32_t pvalue( int i ){
-    return ph[i];
+  int target(){
+    return fill;
   }
 
-  int read_count(){
-    return report_count;
+  int read( int32_t *m, int32_t *p ){  // consumer side, the EER interrupt.  Returns 0 on underrun.
+    int t = tail;
+    if( t == head ){
+      ++underruns;
+      return 0;
+    }
+    *m = mag[t];
+    *p = ph[t];
+    tail = ( t + 1 ) & ( AUDIO_BLOCK_SAMPLES - 1 );
+    return 1;
   }
+
+  volatile uint32_t underruns;         // EER read from an empty ring
+  volatile uint32_t overruns;          // samples lost with the ring full
   
 private:
   int mode;
+  int rate;
+  int fill;                            // target level, sets the delay from audio in to RF out
   audio_block_t *inputQueueArray[1];
-  int mag[AUDIO_BLOCK_SAMPLES];         // 4 blocks of out samples 12ms long  |     6 blocks, 18ms long
-  int  ph[AUDIO_BLOCK_SAMPLES];         // at decimation rate of 4            |     at decimation rate of 6
-  int count;                            // data in index
-  int report_count;                     // report the block ending count
-  int avail;                            // becomes true when we have buffered 6ms of data
+  volatile int mag[AUDIO_BLOCK_SAMPLES];   // single producer single consumer ring, 128 samples
+  volatile int  ph[AUDIO_BLOCK_SAMPLES];   // 17ms at decimation rate of 6
+  volatile int head;                   // written by update only
+  volatile int tail;                   // written by read only
+  int avail;
 };
 
 
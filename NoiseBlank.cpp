@@ -0,0 +1,98 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Development of this audio library was funded by PJRC.COM, LLC by sales of
+ * Teensy and Audio Adaptor boards.  Please support PJRC's efforts to develop
+ * open source software by purchasing Teensy or other PJRC products.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <Arduino.h>
+#include "NoiseBlank.h"
+
+// magnitude estimate, max or 7/8 max + 1/2 min, same as fastAM2 in MagPhase
+static inline int32_t nb_mag( int32_t i, int32_t q ){
+int32_t mx, mn;
+
+   i = abs(i), q = abs(q);
+   if( i > q ) mx = i, mn = q;
+   else mx = q, mn = i;
+   if( mn <= ( mx >> 2 ) ) return mx;
+   return mx - ( mx >> 3 ) + ( mn >> 1 );
+}
+
+void AudioNoiseBlank1::update(void){
+DSP_TIMER( cycles );
+audio_block_t *blki, *blkq;
+int16_t xi[NB_DELAY + AUDIO_BLOCK_SAMPLES];
+int16_t xq[NB_DELAY + AUDIO_BLOCK_SAMPLES];
+int32_t m, avg;
+int k;
+
+   if( thr == 0 || bypassed ){
+      blki = receiveReadOnly(0);
+      blkq = receiveReadOnly(1);
+      if( blki ) transmit( blki, 0 ), release( blki );
+      if( blkq ) transmit( blkq, 1 ), release( blkq );
+      last_det = -1000;
+      return;
+   }
+
+   blki = receiveWritable(0);
+   blkq = receiveWritable(1);
+   if( blki == 0 || blkq == 0 ){
+      if( blki ) release( blki );
+      if( blkq ) release( blkq );
+      return;
+   }
+
+   for( k = 0; k < NB_DELAY; ++k ) xi[k] = hist_i[k], xq[k] = hist_q[k];
+   for( k = 0; k < AUDIO_BLOCK_SAMPLES; ++k ) xi[k+NB_DELAY] = blki->data[k], xq[k+NB_DELAY] = blkq->data[k];
+
+   // output k is input k - NB_DELAY.  It is blanked if an impulse was seen in inputs k - NB_DELAY - NB_POST to k.
+   // An impulse goes into the average at the threshold, so a new strong signal is accepted after a few ms.
+   avg = ( acc >> 8 ) + 1;
+   for( k = 0; k < AUDIO_BLOCK_SAMPLES; ++k ){
+      m = nb_mag( blki->data[k], blkq->data[k] );
+      if( ( m << 4 ) > thr * avg ){
+         last_det = k;
+         m = ( thr * avg ) >> 4;
+      }
+      acc += m - avg;
+      avg = ( acc >> 8 ) + 1;
+      if( k - last_det <= NB_DELAY + NB_POST ){
+         blki->data[k] = blkq->data[k] = 0;
+         ++blanked;
+      }
+      else{
+         blki->data[k] = xi[k];
+         blkq->data[k] = xq[k];
+      }
+   }
+
+   for( k = 0; k < NB_DELAY; ++k ) hist_i[k] = xi[k+AUDIO_BLOCK_SAMPLES], hist_q[k] = xq[k+AUDIO_BLOCK_SAMPLES];
+   last_det -= AUDIO_BLOCK_SAMPLES;
+   if( last_det < -1000 ) last_det = -1000;
+
+   transmit( blki, 0 );
+   transmit( blkq, 1 );
+   release( blki );
+   release( blkq );
+}
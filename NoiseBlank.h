@@ -0,0 +1,76 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Development of this audio library was funded by PJRC.COM, LLC by sales of
+ * Teensy and Audio Adaptor boards.  Please support PJRC's efforts to develop
+ * open source software by purchasing Teensy or other PJRC products.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Impulse noise blanker on the raw I and Q, ahead of the Weaver filters where an impulse would ring for many samples.
+// An impulse is a sample whose I Q magnitude is over a multiple of the running average magnitude.  The output is
+// delayed by NB_DELAY samples so the blanking can start before the sample that was detected, and it runs NB_POST
+// samples past the last one.  Blanked samples are zeroed.  Level 0 passes through.
+
+#ifndef NoiseBlank_h_
+#define NoiseBlank_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+#include "DspCycles.h"
+
+#define NB_DELAY   6                  // look ahead, 136us
+#define NB_POST   10                  // blanked after the last impulse sample
+
+class AudioNoiseBlank1 : public AudioStream
+{
+
+public:
+	AudioNoiseBlank1(void) : AudioStream(2, inputQueueArray) {
+	  thr = 0;
+	  bypassed = 0;
+	  last_det = -1000;
+	  acc = 0;
+	  blanked = 0;
+	}
+	
+	virtual void update(void);
+	struct DSP_CYCLES cycles;            // of update(), DWT cycles
+
+  void level( int l ){                // 0 off, 1 blanks at 22 times the average to 10 at 4 times
+    l = constrain( l, 0, 10 );
+    thr = ( l ) ? 4 * 16 + ( 10 - l ) * 2 * 16 : 0;    // Q4
+  }
+
+  void bypass( int b ){ bypassed = b; }   // transmit uses the Q channel for the microphone
+
+  volatile uint32_t blanked;          // samples blanked
+
+private:
+  int32_t thr;                        // Q4 multiple of the average
+  int bypassed;
+  int last_det;                       // input index of the last impulse, relative to this block
+  int32_t acc;                        // average magnitude, 8 bits fractional
+  int16_t hist_i[NB_DELAY];
+  int16_t hist_q[NB_DELAY];
+  audio_block_t *inputQueueArray[2];
+};
+
+#endif
@@ -0,0 +1,113 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Development of this audio library was funded by PJRC.COM, LLC by sales of
+ * Teensy and Audio Adaptor boards.  Please support PJRC's efforts to develop
+ * open source software by purchasing Teensy or other PJRC products.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <Arduino.h>
+#include "NoiseReduce.h"
+
+static const int16_t nr_window[NR_FFT] = {        // sqrt of periodic hann, squares overlap add to 1 at 50%
+      0,  1608,  3212,  4808,  6393,  7962,  9512, 11039,
+  12539, 14010, 15446, 16846, 18204, 19519, 20787, 22005,
+  23170, 24279, 25329, 26319, 27245, 28105, 28898, 29621,
+  30273, 30852, 31356, 31785, 32137, 32412, 32609, 32728,
+  32767, 32728, 32609, 32412, 32137, 31785, 31356, 30852,
+  30273, 29621, 28898, 28105, 27245, 26319, 25329, 24279,
+  23170, 22005, 20787, 19519, 18204, 16846, 15446, 14010,
+  12539, 11039,  9512,  7962,  6393,  4808,  3212,  1608
+};
+
+#define NR_FLOOR  3277                            // -20 db
+
+// magnitude estimate, max or 7/8 max + 1/2 min, same as fastAM2 in MagPhase
+static inline int32_t nr_mag( int32_t i, int32_t q ){
+int32_t mx, mn;
+
+   i = abs(i), q = abs(q);
+   if( i > q ) mx = i, mn = q;
+   else mx = q, mn = i;
+   if( mn <= ( mx >> 2 ) ) return mx;
+   return mx - ( mx >> 3 ) + ( mn >> 1 );
+}
+
+void AudioNoiseReduce1::update(void){
+DSP_TIMER( cycles );
+audio_block_t *blk;
+int16_t low[NR_HOP];
+int32_t m, g, y;
+int i, k;
+
+   blk = receiveWritable(0);
+   if( blk == 0 ) return;
+   if( alpha == 0 ){
+      transmit( blk );
+      release( blk );
+      return;
+   }
+
+   decimate4( &dec, blk->data, low );
+
+   for( i = 0; i < NR_HOP; ++i ){                  // last hop and this one, windowed, q31
+      buffer[2*i] = ( prev[i] * nr_window[i] ) << 1;
+      buffer[2*i+1] = 0;
+      buffer[2*(i+NR_HOP)] = ( low[i] * nr_window[i+NR_HOP] ) << 1;
+      buffer[2*(i+NR_HOP)+1] = 0;
+      prev[i] = low[i];
+   }
+
+   arm_cfft_radix4_q31( &fft_inst, buffer );
+
+   for( k = 0; k < NR_BINS; ++k ){
+      m = nr_mag( buffer[2*k], buffer[2*k+1] );
+      if( m < noise[k] ) noise[k] -= ( noise[k] - m ) >> 3;
+      else noise[k] += (( m - noise[k] ) >> 8 ) + 1;
+
+      if( m <= 0 ) g = NR_FLOOR;
+      else{
+         g = 32767 - (int32_t)((( (int64_t)noise[k] * alpha ) << 7 ) / m );
+         if( g < NR_FLOOR ) g = NR_FLOOR;
+      }
+      gain[k] += ( g - gain[k] ) >> 1;
+
+      buffer[2*k]   = ( (int64_t)buffer[2*k]   * gain[k] ) >> 15;
+      buffer[2*k+1] = ( (int64_t)buffer[2*k+1] * gain[k] ) >> 15;
+      if( k > 0 && k < NR_FFT/2 ){                 // the mirror bin of a real signal
+         buffer[2*(NR_FFT-k)]   = ( (int64_t)buffer[2*(NR_FFT-k)]   * gain[k] ) >> 15;
+         buffer[2*(NR_FFT-k)+1] = ( (int64_t)buffer[2*(NR_FFT-k)+1] * gain[k] ) >> 15;
+      }
+   }
+
+   arm_cfft_radix4_q31( &ifft_inst, buffer );     // both directions scale by 1/64, made up in the shift of 10
+
+   for( i = 0; i < NR_FFT; ++i ){
+      y = signed_saturate_rshift( buffer[2*i], 16, 10 );
+      y = ( y * nr_window[i] ) >> 15;
+      if( i < NR_HOP ) low[i] = saturate16( ola[i] + y );
+      else ola[i-NR_HOP] = y;
+   }
+
+   interpolate4( &interp, low, blk->data );
+   transmit( blk );
+   release( blk );
+}
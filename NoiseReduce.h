@@ -0,0 +1,87 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Development of this audio library was funded by PJRC.COM, LLC by sales of
+ * Teensy and Audio Adaptor boards.  Please support PJRC's efforts to develop
+ * open source software by purchasing Teensy or other PJRC products.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Spectral subtraction noise reduction.  The audio is decimated by 4 to 11029 hz and each block of 32 low rate samples
+// is one hop of a 64 point FFT with 50% overlap, sqrt hann windows in and out.  Every bin has a noise floor that falls
+// quickly and rises slowly, so it follows the level between words and code elements.  The bin gain is 1 less the
+// noise to signal ratio times the strength, with a -20 db floor, and is smoothed over two hops to keep down the
+// musical noise.  Integer only, q31 FFT so the quiet bins keep their resolution.  Strength 0 passes the audio through.
+
+#ifndef NoiseReduce_h_
+#define NoiseReduce_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+#include "DspCycles.h"
+#include "arm_math.h"
+#include "Decimate4.h"
+
+#define NR_FFT   64
+#define NR_HOP   DEC4_OUT            // 32, one audio block
+#define NR_BINS  ( NR_FFT/2 + 1 )
+
+class AudioNoiseReduce1 : public AudioStream
+{
+
+public:
+	AudioNoiseReduce1(void) : AudioStream(1, inputQueueArray) {
+	  arm_cfft_radix4_init_q31( &fft_inst, NR_FFT, 0, 1 );
+	  arm_cfft_radix4_init_q31( &ifft_inst, NR_FFT, 1, 1 );
+	  strength( 0 );
+	}
+	
+	virtual void update(void);
+	struct DSP_CYCLES cycles;            // of update(), DWT cycles
+
+  void strength( int s ){             // 0 off to 10
+    int i;
+    s = constrain( s, 0, 10 );
+    alpha = s * 64;                   // over subtraction, Q8, 2.5 at full strength
+    if( s == 0 ){                     // start over next time, no audio from before it was off
+      memset( noise, 0, sizeof( noise ));
+      for( i = 0; i < NR_BINS; ++i ) gain[i] = 32767;
+      memset( &dec, 0, sizeof( dec ));
+      memset( &interp, 0, sizeof( interp ));
+      memset( prev, 0, sizeof( prev ));
+      memset( ola, 0, sizeof( ola ));
+    }
+  }
+
+private:
+  int32_t alpha;
+  audio_block_t *inputQueueArray[1];
+  arm_cfft_radix4_instance_q31 fft_inst;
+  arm_cfft_radix4_instance_q31 ifft_inst;
+  struct DECIM4 dec;
+  struct INTERP4 interp;
+  int16_t prev[NR_HOP];               // last hop of input
+  int16_t ola[NR_HOP];                // second half of the last output frame
+  int32_t noise[NR_BINS];
+  int16_t gain[NR_BINS];              // Q15, smoothed
+  int32_t buffer[2*NR_FFT] __attribute__ ((aligned (4)));
+};
+
+#endif
@@ -0,0 +1,90 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Development of this audio library was funded by PJRC.COM, LLC by sales of
+ * Teensy and Audio Adaptor boards.  Please support PJRC's efforts to develop
+ * open source software by purchasing Teensy or other PJRC products.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <Arduino.h>
+#include "NotchLMS.h"
+#include "utility/dspinst.h"
+
+#define NOTCH_COUNT  2756              // low rate samples in a frequency count, 1/4 second
+
+void AudioNotchLMS1::update(void){
+DSP_TIMER( cycles );
+audio_block_t *blk;
+int16_t y[DEC4_OUT];
+int16_t tone[AUDIO_BLOCK_SAMPLES];
+int16_t *xn;
+int32_t pa, kq, ke, e;
+int64_t acc;
+int i, k, n;
+
+   blk = receiveWritable(0);
+   if( blk == 0 ) return;
+   if( mu == 0 ){
+      transmit( blk );
+      release( blk );
+      return;
+   }
+
+   xn = x + NOTCH_HIST;
+   decimate4( &dec, blk->data, xn );
+
+   pa = 0;                                         // mean square of this block, step is normalized by it
+   for( n = 0; n < DEC4_OUT; ++n ) pa += ( xn[n] * xn[n] ) >> 5;
+   if( pa < 1024 ) pa = 1024;
+   kq = ( (int64_t)mu << 22 ) / ( NOTCH_TAPS * (int64_t)pa );     // Q8
+   if( kq > 32767 ) kq = 32767;
+
+   for( n = 0; n < DEC4_OUT; ++n ){
+      acc = 0;
+      for( k = 0; k < NOTCH_TAPS; ++k ) acc += (int64_t)w[k] * xn[n - NOTCH_DELAY - k];
+      y[n] = signed_saturate_rshift( (int32_t)( acc >> 16 ), 16, 14 );
+      e = saturate16( xn[n] - y[n] );
+      ke = kq * e;
+      for( k = 0; k < NOTCH_TAPS; ++k ) w[k] += ( (int64_t)ke * xn[n - NOTCH_DELAY - k] ) >> 8;
+
+      if( ( y[n] ^ last_y ) < 0 ) ++crossings;      // frequency count
+      last_y = y[n];
+      if( abs( y[n] ) > peak ) peak = abs( y[n] );
+      if( ++count >= NOTCH_COUNT ){
+         hz = crossings * 2;                        // half a cycle per crossing over 1/4 second
+         lvl = peak;
+         crossings = count = peak = 0;
+      }
+   }
+   for( k = 0; k < NOTCH_TAPS; ++k ) w[k] -= w[k] >> 12;     // leak so the weights can't wander
+   for( i = 0; i < NOTCH_HIST; ++i ) x[i] = x[i + DEC4_OUT];
+
+   interpolate4( &interp, y, tone );
+
+   for( i = 0; i < AUDIO_BLOCK_SAMPLES; ++i ){      // delay the audio to line up with the carrier and subtract
+      e = ( i < NOTCH_ALIGN ) ? dly[i] : blk->data[i - NOTCH_ALIGN];
+      if( i >= AUDIO_BLOCK_SAMPLES - NOTCH_ALIGN ) dly[i - AUDIO_BLOCK_SAMPLES + NOTCH_ALIGN] = blk->data[i];
+      tone[i] = saturate16( e - tone[i] );
+   }
+   for( i = 0; i < AUDIO_BLOCK_SAMPLES; ++i ) blk->data[i] = tone[i];
+   transmit( blk );
+   release( blk );
+}
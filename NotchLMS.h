@@ -0,0 +1,78 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Development of this audio library was funded by PJRC.COM, LLC by sales of
+ * Teensy and Audio Adaptor boards.  Please support PJRC's efforts to develop
+ * open source software by purchasing Teensy or other PJRC products.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Automatic notch.  An LMS line enhancer at 1/4 rate predicts the audio from samples NOTCH_DELAY back, which only a
+// steady carrier survives.  The prediction is the carrier, it is brought back up to 44117 and subtracted from the
+// full rate audio delayed to match the two filters, so the rest of the audio never goes through the 11k rate.
+// Normalized by the block power, integer only.  The carrier frequency is counted from the prediction zero crossings.
+
+#ifndef NotchLMS_h_
+#define NotchLMS_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+#include "DspCycles.h"
+#include "Decimate4.h"
+
+#define NOTCH_TAPS    16
+#define NOTCH_DELAY    8              // decorrelation, 0.7ms at 11k
+#define NOTCH_ALIGN   60              // full rate delay of decimate4 then interpolate4
+#define NOTCH_HIST    ( NOTCH_DELAY + NOTCH_TAPS )
+
+class AudioNotchLMS1 : public AudioStream
+{
+
+public:
+	AudioNotchLMS1(void) : AudioStream(1, inputQueueArray) {
+	  rate( 0 );
+	}
+	
+	virtual void update(void);
+	struct DSP_CYCLES cycles;            // of update(), DWT cycles
+
+  void rate( int r ){                 // convergence rate, 0 off to 10
+    r = constrain( r, 0, 10 );
+    mu = r * r * 20;                  // Q16, 0.0003 to 0.03
+    if( r == 0 ) memset( w, 0, sizeof( w ));
+  }
+
+  int frequency(){ return hz; }       // of the carrier being notched, updated 4 times a second
+  int level(){ return lvl; }          // peak of the prediction in the last count
+
+private:
+  int32_t mu;
+  int32_t w[NOTCH_TAPS];              // Q30
+  int16_t x[NOTCH_HIST + DEC4_OUT];   // low rate history then this block
+  int16_t dly[NOTCH_ALIGN];           // full rate delay
+  struct DECIM4 dec;
+  struct INTERP4 interp;
+  int16_t last_y;
+  int crossings, count, peak;
+  volatile int hz, lvl;
+  audio_block_t *inputQueueArray[1];
+};
+
+#endif
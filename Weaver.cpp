@@ -0,0 +1,306 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Development of this audio library was funded by PJRC.COM, LLC by sales of
+ * Teensy and Audio Adaptor boards.  Please support PJRC's efforts to develop
+ * open source software by purchasing Teensy or other PJRC products.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <Arduino.h>
+#include "Weaver.h"
+#include "utility/dspinst.h"
+
+#define SAM_KP  5340                  // phase and frequency gains of the carrier pll, per block
+#define SAM_KI    22
+#define SAM_KF   326                  // frequency loop, 1/8 of the error each step, until the pll locks
+#define SAM_SUB    8                  // samples in a frequency loop step
+
+#define WV_FADE_SHIFT  5              // a coefficient change fades from the old filter over one 32 sample block
+
+// every filter the receiver uses, made by the compiler
+static constexpr int wv_roof_hz[] = { 1250, 2000, 3000 };                           // CW, SSB, AM and DIGI
+static constexpr int wv_hp_hz[] = { 100, 200, 250, 550 };
+static constexpr int wv_lp_hz[] = { 300, 850, 900, 1150, 2700, 3000, 3300, 3600 };   // menu and CW narrow filters
+#define WV_ROOFS  ( sizeof( wv_roof_hz ) / sizeof( int ))
+#define WV_HPS    ( sizeof( wv_hp_hz ) / sizeof( int ))
+#define WV_LPS    ( sizeof( wv_lp_hz ) / sizeof( int ))
+#define WV_TONES  ( 2 * WEAVER_TONE + 1 )
+
+struct WV_BANK {
+   WV_COEF roof[WV_ROOFS][WEAVER_STAGES];
+   uint32_t bfo[WV_ROOFS];
+   WV_COEF hp[WV_HPS];
+   WV_COEF lp[WV_LPS][WV_TONES][WEAVER_STAGES - 1];
+   constexpr WV_BANK() : roof(), bfo(), hp(), lp() {
+      for( unsigned int r = 0; r < WV_ROOFS; ++r ){                  // Butterworth Q's for 4 cascade
+         roof[r][0] = fb_biquad( wv_roof_hz[r], 0.50979558, 0, WEAVER_RATE );
+         roof[r][1] = fb_biquad( wv_roof_hz[r], 0.60134489, 0, WEAVER_RATE );
+         roof[r][2] = fb_biquad( wv_roof_hz[r], 0.89997622, 0, WEAVER_RATE );
+         roof[r][3] = fb_biquad( wv_roof_hz[r], 2.5629154, 0, WEAVER_RATE );
+         bfo[r] = wv_roof_hz[r] * ( 4294967296.0 / WEAVER_RATE );
+      }
+      for( unsigned int h = 0; h < WV_HPS; ++h ) hp[h] = fb_biquad( wv_hp_hz[h], 0.70710678, 1, WEAVER_RATE );
+      for( unsigned int l = 0; l < WV_LPS; ++l ){                     // tone moves the Q's
+         for( unsigned int t = 0; t < WV_TONES; ++t ){
+            double tq = ( (int)t - WEAVER_TONE ) * WEAVER_TONE_Q;
+            lp[l][t][0] = fb_biquad( wv_lp_hz[l], 0.51763809 + tq, 0, WEAVER_RATE );
+            lp[l][t][1] = fb_biquad( wv_lp_hz[l], 0.70710678 + tq, 0, WEAVER_RATE );
+            lp[l][t][2] = fb_biquad( wv_lp_hz[l], 1.9318517 + tq/2, 0, WEAVER_RATE );
+         }
+      }
+   }
+};
+
+static constexpr WV_BANK wv_bank;
+
+static int wv_nearest( const int *tab, int n, int hz ){
+int i, best;
+
+   best = 0;
+   for( i = 1; i < n; ++i ) if( abs( tab[i] - hz ) < abs( tab[best] - hz ) ) best = i;
+   return best;
+}
+
+static inline int32_t sam_mag( int32_t i, int32_t q ){
+
+   i = abs( i ), q = abs( q );
+   return ( i > q ) ? i + ( q >> 1 ) : q + ( i >> 1 );
+}
+
+extern "C" {
+extern const int16_t AudioWaveformSine[257];
+}
+
+// interpolated table lookup, same as AudioSynthWaveformSine
+static inline int32_t wv_sine( uint32_t ph ){
+uint32_t index, scale;
+
+   index = ph >> 24;
+   scale = ( ph >> 8 ) & 0xFFFF;
+   return ( AudioWaveformSine[index] * (int32_t)( 0x10000 - scale ) + AudioWaveformSine[index+1] * (int32_t)scale ) >> 16;
+}
+
+static inline int32_t wv_biquad( const struct WV_COEF *c, struct WV_STATE *s, int32_t x ){
+int64_t acc;
+int32_t y;
+
+   acc = (int64_t)c->b0 * x + (int64_t)c->b1 * s->x1 + (int64_t)c->b2 * s->x2
+       - (int64_t)c->a1 * s->y1 - (int64_t)c->a2 * s->y2;
+   y = acc >> 30;
+   s->x2 = s->x1;  s->x1 = x;
+   s->y2 = s->y1;  s->y1 = y;
+   return y;
+}
+
+static inline int32_t wv_cascade( const struct WV_CASCADE *c, struct WV_STATE *s, int32_t x ){
+int i;
+
+   for( i = 0; i < WEAVER_STAGES; ++i ) x = wv_biquad( c->k[i], &s[i], x );
+   return x;
+}
+
+// f is how much of the old filter is left, out of 32.  The old filter runs on its own copy of the state.
+static inline int32_t wv_filter( const struct WV_CASCADE *c, const struct WV_CASCADE *old, struct WV_STATE *s,
+                                 struct WV_STATE *so, int f, int32_t x ){
+int32_t y;
+
+   y = wv_cascade( c, s, x );
+   if( f ) y += ( (int64_t)( wv_cascade( old, so, x ) - y ) * f ) >> WV_FADE_SHIFT;
+   return y;
+}
+
+// frequency loop for pulling in.  The carrier angle change between two sub block sums gives the frequency error
+// directly, good to +-690 hz, where a block rate pll alone would only catch a carrier a few tens of hz away.
+void AudioWeaver1::sam_fll( int32_t i, int32_t q ){
+int64_t cross, norm;
+
+   cross = (int64_t)fll_i * q - (int64_t)fll_q * i;
+   norm = (int64_t)sam_mag( fll_i, fll_q ) * sam_mag( i, q );
+   fll_i = i;  fll_q = q;
+   if( norm < 4096 ) return;
+   sam_inc += (int32_t)( ( cross << 15 ) / norm ) * SAM_KF;
+   sam_inc = constrain( sam_inc, sam_inc0 - sam_range, sam_inc0 + sam_range );
+}
+
+// synchronous AM.  m gets the audio in the same Q8 units as the Weaver path.
+void AudioWeaver1::sam( const int16_t *di, const int16_t *dq, int32_t *m, int rf ){
+int16_t *hq, *id;
+int32_t h[DEC4_OUT];
+int32_t yi, yq, ci, cq, bi, bq, c, s, mag, err;
+uint32_t z;
+int i, f;
+
+   hq = hil.x + HILBERT_HIST;
+   id = idly + HILBERT_HIST/2;
+   ci = cq = bi = bq = 0;
+   for( i = 0; i < DEC4_OUT; ++i ){
+      c = wv_sine( sam_phase + 0x40000000 );
+      s = wv_sine( sam_phase );
+      sam_phase += sam_inc;
+      z = pack_16b_16b( dq[i], di[i] );                                      // Q top, I bottom
+      yi = multiply_16tx16t_add_16bx16b( z, pack_16b_16b( s, c ) ) >> 15;    // I*c + Q*s
+      yq = multiply_16tx16t_add_16bx16b( z, pack_16b_16b( c, -s ) ) >> 15;   // Q*c - I*s
+      f = rf ? rf - i : 0;
+      yi = saturate16( wv_filter( &roof, &roof_old, si, si_old, f, yi << 8 ) >> 8 );
+      yq = saturate16( wv_filter( &roof, &roof_old, sq, sq_old, f, yq << 8 ) >> 8 );
+      bi += yi;  bq += yq;
+      if( ( i % SAM_SUB ) == SAM_SUB - 1 ){
+         if( locked() == 0 ) sam_fll( bi, bq );
+         ci += bi;  cq += bq;
+         bi = bq = 0;
+      }
+      id[i] = yi;  hq[i] = yq;
+   }
+
+   if( sb == WEAVER_SAM ) for( i = 0; i < DEC4_OUT; ++i ) m[i] = id[i] << 8;
+   else{
+      hilbert31( &hil, DEC4_OUT, h, 0 );
+      for( i = 0; i < DEC4_OUT; ++i ){
+         if( sb == WEAVER_SAM_U ) m[i] = ( idly[i] - h[i] ) << 7;
+         else m[i] = ( idly[i] + h[i] ) << 7;
+      }
+   }
+   for( i = 0; i < HILBERT_HIST/2; ++i ) idly[i] = idly[i + DEC4_OUT];
+
+   // pll once a block.  The phase error is the angle of the summed carrier, normalized so the loop gain doesn't
+   // depend on signal level.  About 10 hz natural frequency, 0.7 damping.
+   mag = sam_mag( ci, cq );
+   if( mag < DEC4_OUT * 8 ) return;                                          // nothing there to lock on
+   err = ( cq << 10 ) / ( mag >> 5 );                                        // sin of the error, Q15
+   sam_phase += err * SAM_KP;
+   sam_inc += err * SAM_KI;
+   sam_inc = constrain( sam_inc, sam_inc0 - sam_range, sam_inc0 + sam_range );
+   sam_lock += ( ( ( ci << 10 ) / ( mag >> 5 ) ) - sam_lock ) >> 4;
+   sam_hz = ( (int64_t)( sam_inc - sam_inc0 ) * (int32_t)WEAVER_RATE ) >> 32;
+}
+
+void AudioWeaver1::update(void){
+DSP_TIMER( cycles );
+audio_block_t *blki, *blkq, *out0, *out1;
+int16_t di[DEC4_OUT], dq[DEC4_OUT];
+int16_t a0[DEC4_OUT], a1[DEC4_OUT];
+int32_t m[DEC4_OUT];
+int32_t yi, yq, c, s;
+int i, f, rf, bf;
+
+   blki = receiveReadOnly(0);
+   blkq = receiveReadOnly(1);
+   if( blki == 0 || blkq == 0 ){
+      if( blki ) release( blki );
+      if( blkq ) release( blkq );
+      return;
+   }
+   decimate4( &deci, blki->data, di );
+   decimate4( &decq, blkq->data, dq );
+   release( blki );
+   release( blkq );
+
+   rf = bf = 0;                                    // swap in new coefficients, the old ones fade out this block
+   if( roof_ready ){
+      roof_old = roof;
+      roof = roof_new;
+      phase_inc = bfo_new;
+      memcpy( si_old, si, sizeof( si ));
+      memcpy( sq_old, sq, sizeof( sq ));
+      roof_ready = 0;
+      rf = 1 << WV_FADE_SHIFT;
+   }
+   if( bw_ready ){
+      bw_old = bw;
+      bw = bw_new;
+      memcpy( sa_old, sa, sizeof( sa ));
+      bw_ready = 0;
+      bf = 1 << WV_FADE_SHIFT;
+   }
+
+   if( sb >= WEAVER_SAM ) sam( di, dq, m, rf );
+   else{
+      for( i = 0; i < DEC4_OUT; ++i ){
+         f = rf ? rf - i : 0;
+         yi = saturate16( wv_filter( &roof, &roof_old, si, si_old, f, di[i] << 8 ) >> 8 );
+         yq = saturate16( wv_filter( &roof, &roof_old, sq, sq_old, f, dq[i] << 8 ) >> 8 );
+         c = wv_sine( phase + 0x40000000 );
+         s = wv_sine( phase );
+         phase += phase_inc;
+         if( sb == WEAVER_LSB ) m[i] = ( ( yi * c ) >> 7 ) + ( ( yq * s ) >> 7 );
+         else m[i] = ( ( yi * c ) >> 7 ) - ( ( yq * s ) >> 7 );
+      }
+   }
+   for( i = 0; i < DEC4_OUT; ++i ){
+      a1[i] = saturate16( m[i] >> 8 );
+      f = bf ? bf - i : 0;
+      a0[i] = saturate16( wv_filter( &bw, &bw_old, sa, sa_old, f, m[i] ) >> 8 );
+   }
+
+   out0 = allocate();
+   out1 = allocate();
+   if( out0 ){
+      interpolate4( &int0, a0, out0->data );
+      transmit( out0, 0 );
+      release( out0 );
+   }
+   if( out1 ){
+      interpolate4( &int1, a1, out1->data );
+      transmit( out1, 1 );
+      release( out1 );
+   }
+}
+
+void AudioWeaver1::init(){
+int i;
+
+   for( i = 0; i < WEAVER_STAGES; ++i ) roof.k[i] = &wv_bank.roof[1][i];
+   phase_inc = wv_bank.bfo[1];
+   bw.k[0] = &wv_bank.hp[1];
+   for( i = 1; i < WEAVER_STAGES; ++i ) bw.k[i] = &wv_bank.lp[5][WEAVER_TONE][i-1];
+   roof_old = roof_new = roof;
+   bw_old = bw_new = bw;
+   roof_ready = bw_ready = 0;
+}
+
+// the roofing lowpass and BFO from the bank, nearest to hz
+void AudioWeaver1::weaver( int hz ){
+int r, i;
+
+   r = wv_nearest( wv_roof_hz, WV_ROOFS, hz );
+   if( roof_ready == 0 && roof.k[0] == &wv_bank.roof[r][0] ) return;
+   roof_ready = 0;
+   for( i = 0; i < WEAVER_STAGES; ++i ) roof_new.k[i] = &wv_bank.roof[r][i];
+   bfo_new = wv_bank.bfo[r];
+   roof_ready = 1;
+}
+
+// highpass stage and a 3 stage lowpass from the bank.  tone is -WEAVER_TONE to WEAVER_TONE.
+void AudioWeaver1::bandwidth( int hp, int lp, int tone ){
+struct WV_CASCADE c;
+int h, l, i;
+
+   h = wv_nearest( wv_hp_hz, WV_HPS, hp );
+   l = wv_nearest( wv_lp_hz, WV_LPS, lp );
+   tone = constrain( tone, -WEAVER_TONE, WEAVER_TONE ) + WEAVER_TONE;
+   c.k[0] = &wv_bank.hp[h];
+   for( i = 1; i < WEAVER_STAGES; ++i ) c.k[i] = &wv_bank.lp[l][tone][i-1];
+   if( bw_ready == 0 && memcmp( &c, &bw, sizeof( c )) == 0 ) return;         // no change, no fade
+   bw_ready = 0;
+   bw_new = c;
+   bw_ready = 1;
+}
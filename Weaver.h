@@ -0,0 +1,119 @@
+/* Audio Library for Teensy 3.X
+ * Copyright (c) 2014, Paul Stoffregen, paul@pjrc.com
+ *
+ * Development of this audio library was funded by PJRC.COM, LLC by sales of
+ * Teensy and Audio Adaptor boards.  Please support PJRC's efforts to develop
+ * open source software by purchasing Teensy or other PJRC products.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, development funding notice, and this permission
+ * notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// Weaver receiver at 1/4 rate.  I and Q are decimated to 11029 hz, lowpassed to half the Weaver bandwidth, mixed with
+// a complex BFO and added or subtracted for the sideband.  The BandWidth filter follows at the low rate, then the audio is
+// interpolated back to 44117.  Replaces ILow, the BFO sines, the mixers, the SSB adder and BandWidth at the full rate.
+// Output 0 is the filtered audio, output 1 is the audio ahead of the BandWidth filter for the skimmer.
+// AM is a synchronous detector.  A phase locked NCO brings the carrier to dc, the roofing lowpass is the audio
+// bandwidth, and the real part is the audio.  One sideband is picked with the Hilbert31 on the imaginary part.  The PLL
+// is updated once a block from the block sum of the carrier, with a frequency loop to pull it in from further off.
+// Biquads are direct form 1 with Q30 coefficients and 8 extra bits on the samples.  The coefficients come from a table
+// made at compile time ( FilterBank.h ).  A change is handed over with a ready flag and the old filter is faded out
+// over the next block so there is no thump.
+
+#ifndef Weaver_h_
+#define Weaver_h_
+
+#include "Arduino.h"
+#include "AudioStream.h"
+#include "DspCycles.h"
+#include "Decimate4.h"
+#include "Hilbert31.h"
+#include "FilterBank.h"
+
+#define WEAVER_USB   0                // I*cos - Q*sin
+#define WEAVER_LSB   1                // I*cos + Q*sin, also CW
+#define WEAVER_SAM   2                // synchronous AM, both sidebands
+#define WEAVER_SAM_U 3                // upper sideband only
+#define WEAVER_SAM_L 4                // lower sideband only
+
+#define WEAVER_SAM_HZ   1000          // AM is tuned this far off so the carrier is out of the adc dc block
+#define WEAVER_SAM_PULL  500          // pll range either side of that
+
+#define WEAVER_RATE  ( AUDIO_SAMPLE_RATE_EXACT / 4 )
+#define WEAVER_STAGES 4
+#define WEAVER_TONE  20               // tone steps either side of flat
+#define WEAVER_TONE_Q 0.02            // Q change per tone step
+
+struct WV_CASCADE {
+   const struct WV_COEF *k[WEAVER_STAGES];
+};
+
+struct WV_STATE {
+   int32_t x1, x2, y1, y2;
+};
+
+class AudioWeaver1 : public AudioStream
+{
+
+public:
+	AudioWeaver1(void) : AudioStream(2, inputQueueArray) {
+	  init();                     // SSB 3k until set
+	  phase = 0;
+	  sb = WEAVER_USB;
+	  sam_inc0 = -(int32_t)( WEAVER_SAM_HZ * ( 4294967296.0 / WEAVER_RATE ));
+	  sam_range = WEAVER_SAM_PULL * ( 4294967296.0 / WEAVER_RATE );
+	  sam_phase = 0;
+	  sam_inc = sam_inc0;
+	  sam_lock = fll_i = fll_q = 0;
+	}
+	
+	virtual void update(void);
+	struct DSP_CYCLES cycles;            // of update(), DWT cycles
+
+  void weaver( int hz );                                     // roofing lowpass and BFO, half the Weaver bandwidth
+  void sideband( int s ){ sb = s; }
+  void bandwidth( int hp, int lp, int tone );               // the BandWidth filter, nearest in the table
+  int  locked(){ return sam_lock > 29491; }                 // carrier phase error under about 25 degrees
+  int  sam_offset(){ return sam_hz; }                        // carrier distance from the expected spot
+
+private:
+  struct WV_CASCADE roof, roof_old, roof_new;                // roof is shared by I and Q
+  struct WV_CASCADE bw, bw_old, bw_new;
+  volatile int roof_ready, bw_ready;                         // new coefficients waiting for the next block
+  uint32_t bfo_new;
+  struct WV_STATE si[WEAVER_STAGES], sq[WEAVER_STAGES], sa[WEAVER_STAGES];
+  struct WV_STATE si_old[WEAVER_STAGES], sq_old[WEAVER_STAGES], sa_old[WEAVER_STAGES];
+  struct DECIM4 deci, decq;
+  struct INTERP4 int0, int1;
+  uint32_t phase, phase_inc;
+  volatile int sb;
+  uint32_t sam_phase;
+  int32_t sam_inc, sam_inc0, sam_range;                      // carrier NCO, signed so it can be below zero
+  int32_t fll_i, fll_q;                                      // last sub block carrier sum
+  int32_t sam_lock;                                          // average cosine of the phase error, Q15
+  volatile int sam_hz;
+  struct HILBERT31 hil;
+  int16_t idly[HILBERT_HIST/2 + DEC4_OUT];                   // real part delayed to match the hilbert
+  void sam_fll( int32_t i, int32_t q );
+  void sam( const int16_t *di, const int16_t *dq, int32_t *m, int rf );
+  void init();
+  audio_block_t *inputQueueArray[2];
+};
+
+#endif
@@ -30,50 +30,20 @@
 #include <Arduino.h>
 #include "FFT_Scope.h"
 #include "utility/dspinst.h"
+#include "Hilbert31.h"
 
 
-// a 31 tap classic hilbert every other constant is zero, has a plus 90 phase shift.
-static int16_t SSB( int32_t val1, int32_t val2, int mode ){
-static int32_t wi[31];                                // delay terms
-static int32_t wq[31];
-//const int32_t k0 = (int32_t)( 32767.5 * 0.039466626150415629 );      // no window
-//const int32_t k1 = (int32_t)( 32767.5 * 0.045538422602429005 );
-//const int32_t k2 = (int32_t)( 32767.5 * 0.053818143717831897 );
-//const int32_t k3 = (int32_t)( 32767.5 * 0.065777739272219193 );
-//const int32_t k4 = (int32_t)( 32767.5 * 0.084571387356147970 );
-//const int32_t k5 = (int32_t)( 32767.5 * 0.118399951005067283 );
-//const int32_t k6 = (int32_t)( 32767.5 * 0.197333261348968420 );
-//const int32_t k7 = (int32_t)( 32767.5 * 0.591999798557916845 );
-const int32_t k0 = (int32_t)( 32767.5 * 0.002972769320862211 );        // with K window
-const int32_t k1 = (int32_t)( 32767.5 * 0.008171666650726522 );
-const int32_t k2 = (int32_t)( 32767.5 * 0.017465643081957562 );
-const int32_t k3 = (int32_t)( 32767.5 * 0.032878923709314147 );
-const int32_t k4 = (int32_t)( 32767.5 * 0.058021930268698417 );
-const int32_t k5 = (int32_t)( 32767.5 * 0.101629404192315698 );
-const int32_t k6 = (int32_t)( 32767.5 * 0.195583262432201366 );
-const int32_t k7 = (int32_t)( 32767.5 * 0.629544595185021816 );
-int32_t result;
-
-   for( int i = 0; i < 30; ++i )  wi[i] = wi[i+1],  wq[i] = wq[i+1];
-   wi[30] = val1;  wq[30] = val2;
-
-   val2 = wq[15];
-   val1 =  k0 * ( wi[0] - wi[30] ) + k1 * ( wi[2] - wi[28] ) + k2 * ( wi[4] - wi[26] ) + k3 * ( wi[6] - wi[24] );
-   val1 += k4 * ( wi[8] - wi[22] ) + k5 * ( wi[10] - wi[20]) + k6 * ( wi[12] - wi[18]) + k7 * ( wi[14] - wi[16]);
-   val1 >>= 15;
-   result = ( mode == 1 )? val1 + val2 : val1 - val2;      // pick sideband
-   if( result > 32767) result = 32767;
-   if( result < -32767 ) result = -32767;
-   return (int16_t)( result );
-
-}
-
+// The 31 tap classic hilbert has a plus 90 phase shift.  I goes through the hilbert, Q is delayed to match.
+static struct HILBERT31 hil;
+static int16_t qd[HILBERT_HIST/2 + AUDIO_BLOCK_SAMPLES];       // Q delay line, history then new samples
+static int32_t val1[AUDIO_BLOCK_SAMPLES];
 
 
 void AudioFFT_Scope2::update(void){ 
 
     audio_block_t *blk1, *blk2;
     int16_t *dat1, *dat2;
+    int32_t result;
     int i;
 
     // function do nothing 
@@ -99,9 +69,18 @@ void AudioFFT_Scope2::update(void){
     dat1 = blk1->data;
     dat2 = blk2->data;
     for( i = 0; i < AUDIO_BLOCK_SAMPLES; i++ ){
-       *dat1 = SSB( (int32_t)*dat1, (int32_t)*dat2++, mode );
-       ++dat1;                                             
+       hil.x[HILBERT_HIST + i] = dat1[i];
+       qd[HILBERT_HIST/2 + i] = dat2[i];
+    }
+    hilbert31( &hil, AUDIO_BLOCK_SAMPLES, val1, 0 );
+
+    for( i = 0; i < AUDIO_BLOCK_SAMPLES; i++ ){
+       result = ( mode == 1 )? val1[i] + qd[i] : val1[i] - qd[i];      // pick sideband
+       if( result > 32767) result = 32767;
+       if( result < -32767 ) result = -32767;
+       dat1[i] = (int16_t)result;
     }
+    for( i = 0; i < HILBERT_HIST/2; ++i ) qd[i] = qd[AUDIO_BLOCK_SAMPLES + i];
     transmit( blk1 );
     release( blk1 );
     release( blk2 );
@@ -30,6 +30,7 @@ public:
   volatile uint8_t _div;  // note: uint8_t asserts fout > 3.5MHz with R_DIV=1
   volatile uint16_t _msa128min512;
   volatile uint32_t _msb128;
+  volatile uint64_t _dfk;         // _div * _MSC * 128 / fxtal with 38 fraction bits, rounded up.  From freq()
   volatile uint8_t pll_regs[8];
 
   #define BB0(x) ((uint8_t)(x))           // Bash byte x of int32_t
@@ -43,10 +44,17 @@ public:
   //#define F_XTAL 20004000          // A shared-single 20MHz processor/pll clock
   volatile uint32_t fxtal = F_XTAL;
 
-  inline void FAST freq_calc_fast(int16_t df)  // note: relies on cached variables: _msb128, _msa128min512, _div, _fout, fxtal
+  #define DFK_SHIFT 38                  // fraction bits of _dfk, exact for |df| < 2^38/fxtal, 10180 Hz at 27 MHz
+
+  inline void FAST freq_calc_fast(int16_t df)  // note: relies on cached variables: _msb128, _msa128min512, _dfk
   { 
     #define _MSC  0x80000  //0x80000: 98% CPU load   0xFFFFF: 114% CPU load
-    uint32_t msb128 = _msb128 + ((int64_t)(_div * (int32_t)df) * _MSC * 128) / fxtal;
+    //uint32_t msb128 = _msb128 + ((int64_t)(_div * (int32_t)df) * _MSC * 128) / fxtal;   // 64 bit divide, a library call
+    // Same result by multiply and shift.  _dfk is rounded up, and the error over |df| stays under 1/fxtal, less than
+    // the smallest fraction the exact quotient can have, so the truncation matches the divide.
+    uint32_t a = ( df < 0 ) ? -df : df;
+    uint32_t step = ( a * _dfk ) >> DFK_SHIFT;
+    uint32_t msb128 = ( df < 0 ) ? _msb128 - step : _msb128 + step;
 
     //#define _MSC  0xFFFFF  // Old algorithm 114% CPU load, shortcut for a fixed fxtal=27e6
     //register uint32_t xmsb = (_div * (_fout + (int32_t)df)) % fxtal;  // xmsb = msb * fxtal/(128 * _MSC);
@@ -70,10 +78,59 @@ public:
   
   #define SI5351_ADDR 0x60              // I2C address of Si5351   (typical)
 
+  // Shadow copy of what has been written to the chip.  Every write path updates it, so freq() can send only the bytes
+  // that changed.  A register is unknown until it has been written once.  177, the PLL reset, is a strobe and
+  // SendRegister always sends.
+  #define SI_REGS 188
+  #define SI_GAP  2                     // unchanged bytes between changes that are cheaper to resend than a new frame
+  volatile uint8_t shadow[SI_REGS];
+  volatile uint8_t shadow_ok[SI_REGS/8 + 1];     // bit set when the shadow byte is known
+
+  void shadow_set( uint8_t reg, volatile uint8_t *data, uint8_t n ){
+    while( n-- ){
+       if( reg < SI_REGS ){
+          shadow[reg] = *data;
+          shadow_ok[reg >> 3] |= 1 << ( reg & 7 );
+       }
+       ++reg, ++data;
+    }
+  }
+
+  int shadow_same( uint8_t reg, uint8_t val ){
+    if( reg >= SI_REGS || ( shadow_ok[reg >> 3] & ( 1 << ( reg & 7 ))) == 0 ) return 0;
+    return shadow[reg] == val;
+  }
+
+  void shadow_clear(){                  // chip state unknown, the next freq() sends everything
+    memset( (uint8_t *)shadow_ok, 0, sizeof( shadow_ok ));
+    _d = 0;
+  }
+
+  // send the changed bytes of a register block, changes close together go out as one burst.  With last set the last
+  // byte is always sent, like SendPLLBRegisterBulk, so a PLL write always ends on its final register.
+  int changed( uint8_t reg, uint8_t *data, int i, int n, int last ){
+    return ( last && i == n - 1 ) || shadow_same( reg + i, data[i] ) == 0;
+  }
+
+  void SendChanged( uint8_t reg, uint8_t *data, uint8_t n, int last = 0 ){
+  int i, start, end;
+
+    i = 0;
+    while( i < n ){
+       if( changed( reg, data, i, n, last ) == 0 ){
+          ++i;
+          continue;
+       }
+       start = end = i;
+       for( i = start + 1; i < n && i - end <= SI_GAP; ++i ) if( changed( reg, data, i, n, last ) ) end = i;
+       SendRegister( reg + start, data + start, end - start + 1 );
+       i = end + 1;
+    }
+  }
+
   inline void SendPLLBRegisterBulk(){
-  static uint8_t last_reg3;
 
-    if( last_reg3 == pll_regs[3] ){
+    if( shadow_same( 26+1*8 + 3, pll_regs[3] ) ){
        //++saves;
        i2start( SI5351_ADDR );         //i2c.start();
        i2send( 26+1*8 + 4 );           //i2c.SendByte(26+1*8 + 3);  // Write to PLLB
@@ -82,17 +139,19 @@ public:
        i2send( pll_regs[6]);           //i2c.SendByte(pll_regs[6]);
        i2send( pll_regs[7]);           //i2c.SendByte(pll_regs[7]);
        i2stop();                       //i2c.stop();
+       shadow_set( 26+1*8 + 4, &pll_regs[4], 4 );
     }
     else{
        i2start( SI5351_ADDR );         //i2c.start();
                                        //i2c.SendByte(SI5351_ADDR << 1);
        i2send( 26+1*8 + 3 );           //i2c.SendByte(26+1*8 + 3);  // Write to PLLB
-       i2send( ( last_reg3 = pll_regs[3] ));           //i2c.SendByte(pll_regs[3]);
+       i2send( pll_regs[3]);           //i2c.SendByte(pll_regs[3]);
        i2send( pll_regs[4]);           //i2c.SendByte(pll_regs[4]);
        i2send( pll_regs[5]);           //i2c.SendByte(pll_regs[5]);
        i2send( pll_regs[6]);           //i2c.SendByte(pll_regs[6]);
        i2send( pll_regs[7]);           //i2c.SendByte(pll_regs[7]);
        i2stop();                       //i2c.stop();
+       shadow_set( 26+1*8 + 3, &pll_regs[3], 5 );
     }
   }
 
@@ -100,12 +159,98 @@ public:
     i2start( SI5351_ADDR );         //    i2c.start();
                                     //i2c.SendByte(SI5351_ADDR << 1);
     i2send(reg);                    //i2c.SendByte(reg);
+    shadow_set( reg, data, n );
     while (n--) i2send(*data++);    //i2c.SendByte(*data++);
     i2stop();                       //i2c.stop();      
   }
   void SendRegister(uint8_t reg, uint8_t val){ SendRegister(reg, &val, 1); }
+
+  // Transmit register queue.  The EER interrupt queues PLLB frames and the I2C done interrupt sends the next one, so
+  // the frames go out back to back instead of being skipped when the bus is still busy with the last one.
+  // Single producer, single consumer.  q_head is only written by the producer, q_tail only when starting a frame.
+  #define SIQ_SIZE 16                   // power of 2
+  struct SIQ_FRAME {
+    uint8_t reg;
+    uint8_t n;
+    uint8_t data[6];
+  };
+  struct SIQ_FRAME q_frame[SIQ_SIZE];
+  volatile uint8_t q_head, q_tail;
+  volatile uint8_t q_busy;             // a frame from either I2C arbiter lane is on the bus
+  volatile uint16_t q_max;             // counters for the tx status display
+  volatile uint16_t q_late;            // frame queued before the previous one was started
+  volatile uint16_t q_drops;           // queue full
+
+  int queue_depth(){ return ( q_head - q_tail ) & ( SIQ_SIZE - 1 ); }
+
+  void queue_clear(){
+    q_max = q_late = q_drops = 0;
+  }
+
+  void queue_start(){                   // call with the I2C bus idle.  Also the I2C done and error interrupt function.
+  struct SIQ_FRAME *f;
+  int i;
+
+    if( q_tail == q_head ){
+       q_busy = 0;
+       return;
+    }
+    q_busy = 1;
+    f = &q_frame[q_tail];
+    i2start( SI5351_ADDR );
+    i2send( f->reg );
+    for( i = 0; i < f->n; ++i ) i2send( f->data[i] );
+    i2stop();
+    q_tail = ( q_tail + 1 ) & ( SIQ_SIZE - 1 );
+  }
+
+  void queue_reg( uint8_t reg, volatile uint8_t *data, uint8_t n ){
+  struct SIQ_FRAME *f;
+  uint32_t primask;
+  uint8_t h;
+  int i;
+
+    h = ( q_head + 1 ) & ( SIQ_SIZE - 1 );
+    if( h == q_tail ){
+       ++q_drops;
+       return;
+    }
+    f = &q_frame[q_head];
+    f->reg = reg;
+    f->n = n;
+    for( i = 0; i < n; ++i ) f->data[i] = data[i];
+    shadow_set( reg, data, n );
+    q_head = h;                                  // frame is now visible to the I2C interrupt
+
+    i = queue_depth();
+    if( i > 1 ) ++q_late;
+    if( i > q_max ) q_max = i;
+
+    #ifdef __arm__
+    __asm__ volatile( "mrs %0, primask" : "=r" (primask) :: "memory" );
+    #else
+    primask = 0;                                 // host test build, test/i2c_sim
+    #endif
+    __disable_irq();                             // I2C done interrupt must not start a frame between test and start
+    if( q_busy == 0 ) queue_start();
+    if( primask == 0 ) __enable_irq();
+  }
+  void queue_reg( uint8_t reg, uint8_t val ){ queue_reg( reg, &val, 1 ); }
+
+  inline void queue_pllb(){            // queue version of SendPLLBRegisterBulk
+
+    if( shadow_same( 26+1*8 + 3, pll_regs[3] ) ) queue_reg( 26+1*8 + 4, &pll_regs[4], 4 );
+    else queue_reg( 26+1*8 + 3, &pll_regs[3], 5 );
+  }
+
+  void queue_flush(){                  // wait for the queue to empty, interrupts must be enabled
+    while( q_busy );
+  }
   
   int16_t iqmsa; // to detect a need for a PLL reset
+  uint16_t _d;                          // divider, phases and rit of the last freq(), for the fast path
+  uint8_t _i, _q;
+  int _rit;
   
   void freq(uint32_t fout, uint8_t i, uint8_t q, uint16_t d ){  // Set a CLK0,1 to fout Hz with phase i, q
       uint8_t msa; uint32_t msb, msc, msp1, msp2, msp3p2;
@@ -128,24 +273,32 @@ public:
       msp2 = 128*msb - 128*msb/msc * msc;    // msp3 == msc        
       msp3p2 = (((msc & 0x0F0000) <<4) | msp2);  // msp3 on top nibble
       uint8_t pll_regs[8] = { BB1(msc), BB0(msc), BB2(msp1), BB1(msp1), BB0(msp1), BB2(msp3p2), BB1(msp2), BB0(msp2) };
-      SendRegister(26+0*8, pll_regs, 8); // Write to PLLA
-      if( rit_enabled == 0 ) SendRegister(26+1*8, pll_regs, 8); // Write to PLLB unless tx freq is fixed.
-
-      msa = fvcoa / fout;     // Integer part of vco/fout
-      msp1 = (128*msa - 512) | (((uint32_t)rdiv)<<20);     // msp1 and msp2=0, msp3=1, not fractional
-      uint8_t ms_regs[8] = {0, 1, BB2(msp1), BB1(msp1), BB0(msp1), 0, 0, 0};
-      SendRegister(42+0*8, ms_regs, 8); // Write to MS0
-      SendRegister(42+1*8, ms_regs, 8); // Write to MS1
-      if( rit_enabled == 0 ) SendRegister(42+2*8, ms_regs, 8); // Write to MS2
-      SendRegister(16+0, 0x0C|1|0x00);  // CLK0: 0x0C=PLLA local msynth; 3=8mA; 0x40=integer division; bit7:6=0->power-up !!! drive 
-      SendRegister(16+1, 0x0C|1|0x00);  // CLK1: 0x0C=PLLA local msynth; 3=8mA; 0x40=integer division; bit7:6=0->power-up
-      SendRegister(16+2, 0x2C|3|0x00);  // CLK2: 0x2C=PLLB local msynth; 3=8mA; 0x40=integer division; bit7:6=0->power-up
-      SendRegister(165, i * msa / 90);  // CLK0: I-phase (on change -> Reset PLL)
-      SendRegister(166, q * msa / 90);  // CLK1: Q-phase (on change -> Reset PLL)
-      if(iqmsa != ((i-q)*msa/90)  && rit_enabled == 0 ){
-        iqmsa = (i-q)*msa/90; SendRegister(177, 0xA0);
-        } // 0x20 reset PLLA; 0x80 reset PLLB
-      SendRegister(3, 0b11111100);      // Enable/disable clock
+      SendChanged(26+0*8, pll_regs, 8, 1); // Write to PLLA, usually just the fractional bytes
+      if( rit_enabled == 0 ) SendChanged(26+1*8, pll_regs, 8, 1); // Write to PLLB unless tx freq is fixed.
+
+      // fast path.  Same divider, phases and rit, so the multisynths, clock control, phase and enable registers
+      // are all as they were.  Only the PLL's move.
+      if( d != _d || i != _i || q != _q || rit_enabled != _rit ){
+        _d = d;  _i = i;  _q = q;  _rit = rit_enabled;
+        msa = fvcoa / fout;     // Integer part of vco/fout
+        msp1 = (128*msa - 512) | (((uint32_t)rdiv)<<20);     // msp1 and msp2=0, msp3=1, not fractional
+        uint8_t ms_regs[8] = {0, 1, BB2(msp1), BB1(msp1), BB0(msp1), 0, 0, 0};
+        SendChanged(42+0*8, ms_regs, 8); // Write to MS0
+        SendChanged(42+1*8, ms_regs, 8); // Write to MS1
+        if( rit_enabled == 0 ) SendChanged(42+2*8, ms_regs, 8); // Write to MS2
+        uint8_t clk_regs[3] = { 0x0C|1|0x00,   // CLK0: 0x0C=PLLA local msynth; 3=8mA; 0x40=integer division; bit7:6=0->power-up !!! drive 
+                                0x0C|1|0x00,   // CLK1: 0x0C=PLLA local msynth; 3=8mA; 0x40=integer division; bit7:6=0->power-up
+                                0x2C|3|0x00 }; // CLK2: 0x2C=PLLB local msynth; 3=8mA; 0x40=integer division; bit7:6=0->power-up
+        SendChanged(16, clk_regs, 3);
+        uint8_t ph_regs[2] = { (uint8_t)(i * msa / 90),    // CLK0: I-phase (on change -> Reset PLL)
+                               (uint8_t)(q * msa / 90) };  // CLK1: Q-phase (on change -> Reset PLL)
+        SendChanged(165, ph_regs, 2);
+        if(iqmsa != ((i-q)*msa/90)  && rit_enabled == 0 ){
+          iqmsa = (i-q)*msa/90; SendRegister(177, 0xA0);
+          } // 0x20 reset PLLA; 0x80 reset PLLB
+      }
+      uint8_t oe = 0b11111100;
+      SendChanged(3, &oe, 1);           // Enable/disable clock, tx and rx write it directly
 
   //Serial.print( fout/1000 ); Serial.write(' ');        // !!! debug
   //Serial.print( fvcoa/1000 ); Serial.write(' ');
@@ -156,6 +309,8 @@ public:
         _div = d;
         _msa128min512 = fvcoa / fxtal * 128 - 512;
         _msb128=((uint64_t)(fvcoa % fxtal)*_MSC*128) / fxtal;
+        uint64_t r = ((uint64_t)_div << 32) % fxtal;                 // _div * 2^64 / fxtal in two 32 bit steps
+        _dfk = ((((uint64_t)_div << 32) / fxtal) << 32) + ((r << 32) + fxtal - 1) / fxtal;
      }
       
   }
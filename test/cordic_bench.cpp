@@ -0,0 +1,85 @@
+// Accuracy and speed of the MagPhase cordic against arctan3 and fastAM2, the approximations it replaced.  The static
+// functions are taken straight from MagPhase.cpp.  Random I/Q over the hilbert output range are compared with double
+// atan2 and hypot.  Phase error is in MagPhase phase units, ua for one turn at the decimation rate of 6, and magnitude
+// error is a percent of the true value.  Host time per call is for comparing the two, not Teensy cycles.
+//
+// Fails if the cordic phase is outside the limit for its number of steps, the magnitude is off by more than 0.5%, or
+// at the default 12 steps and up it is not at least 4 times better in phase than arctan3.  Build with
+//   make cordic_bench CORDIC=n
+// to try another number of steps.  On the x86 the divide in arctan3 is cheap, the Teensy cost of each is the MagPhase
+// line of DSP_BENCH or #P.
+
+#include <stdio.h>
+#include <chrono>
+#define CORDIC_BENCH                   // keep arctan3 and fastAM2 in MagPhase.cpp
+#include "../MagPhase.cpp"
+
+#define PAIRS 200000
+
+static int32_t vi[PAIRS], vq[PAIRS];
+
+struct ERR {
+   double ph_max, ph_rms, mag_max, ns;
+};
+
+static double wrap( double d ){        // phase difference in -ua/2 to ua/2
+
+   while( d > ua / 2.0 ) d -= ua;
+   while( d < -ua / 2.0 ) d += ua;
+   return d;
+}
+
+static void check( struct ERR *e, const int32_t *p, const int32_t *m ){
+double want, d, mag;
+int n;
+
+   e->ph_max = e->ph_rms = e->mag_max = 0;
+   for( n = 0; n < PAIRS; ++n ){
+      want = atan2( (double)vq[n], (double)vi[n] ) * ua / ( 2 * PI );
+      d = fabs( wrap( p[n] - want ));
+      if( d > e->ph_max ) e->ph_max = d;
+      e->ph_rms += d * d;
+      mag = hypot( (double)vi[n], (double)vq[n] );
+      d = 100.0 * fabs( m[n] - mag ) / mag;
+      if( d > e->mag_max ) e->mag_max = d;
+   }
+   e->ph_rms = sqrt( e->ph_rms / PAIRS );
+}
+
+static int32_t ph[PAIRS], mg[PAIRS];
+
+int main(){
+std::chrono::steady_clock::time_point t0;
+struct ERR c, a;
+uint32_t seed = 1;
+int n, fail;
+
+   for( n = 0; n < PAIRS; ){                         // 16 bit range, skip the tiny ones where 1 count is a big angle
+      seed = seed * 1664525u + 1013904223u;
+      vi[n] = (int16_t)( seed >> 16 );
+      seed = seed * 1664525u + 1013904223u;
+      vq[n] = (int16_t)( seed >> 16 );
+      if( abs( vi[n] ) + abs( vq[n] ) > 256 ) ++n;
+   }
+
+   t0 = std::chrono::steady_clock::now();
+   for( n = 0; n < PAIRS; ++n ) ph[n] = cordic( vq[n], vi[n], &mg[n] );
+   c.ns = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - t0 ).count() / PAIRS;
+   check( &c, ph, mg );
+
+   t0 = std::chrono::steady_clock::now();
+   for( n = 0; n < PAIRS; ++n ) ph[n] = arctan3( vq[n], vi[n] ), mg[n] = fastAM2( vq[n], vi[n] );
+   a.ns = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - t0 ).count() / PAIRS;
+   check( &a, ph, mg );
+
+   printf( "ua %d, %d pairs\n", ua, PAIRS );
+   printf( "                 phase max  phase rms  mag max %%   ns/call\n" );
+   printf( "cordic %2d steps  %9.3f  %9.3f  %9.3f  %8.1f\n", MP_CORDIC, c.ph_max, c.ph_rms, c.mag_max, c.ns );
+   printf( "arctan3 fastAM2  %9.3f  %9.3f  %9.3f  %8.1f\n", a.ph_max, a.ph_rms, a.mag_max, a.ns );
+
+   // each step halves the angle left, 2^-steps of a half turn, plus rounding
+   fail = ( c.ph_max > ua / 2.0 / ( 1 << MP_CORDIC ) * 4 + 1 ) || ( c.mag_max > 0.5 );
+   if( MP_CORDIC >= 12 && c.ph_max * 4 > a.ph_max ) fail = 1;
+   printf( fail ? "FAIL\n" : "ok\n" );
+   return fail;
+}
@@ -0,0 +1,270 @@
+// Host benchmark and golden vector check for the custom audio objects.  Each object is run on the same made up I/Q,
+// two tones, a carrier, noise and some impulses, and a hash of everything it outputs is compared with the value the
+// current code gives.  A change that alters the output of an object shows up as a FAIL, update the table with -g when
+// the change is intended.  Host time per block is printed for comparing versions, it is not the Teensy cycle count,
+// CAT #P gives that.
+//
+//   dsp_bench           check the golden hashes
+//   dsp_bench -g        print the hashes for the table
+//   dsp_bench f.wav     run a 16 bit stereo recording ( I left, Q right ) through the objects, time only
+//
+// FFT_IQ, NoiseReduce and CWSkim run on the reference FFT in host/arm_math.h in place of CMSIS.
+
+#include <stdio.h>
+#include <chrono>
+#include "Arduino.h"
+#include "AudioStream.h"
+#include "../MagPhase.h"
+#include "../Weaver.h"
+#include "../AGC.h"
+#include "../NotchLMS.h"
+#include "../NoiseBlank.h"
+#include "../CWDet.h"
+#include "../FFT_IQ.h"
+#include "../NoiseReduce.h"
+#include "../CWSkim.h"
+
+#define BLOCKS 400
+
+static int16_t src_i[BLOCKS][AUDIO_BLOCK_SAMPLES];
+static int16_t src_q[BLOCKS][AUDIO_BLOCK_SAMPLES];
+static int nblocks = BLOCKS;
+
+static uint32_t hash;                  // FNV-1a of the outputs
+static double ns;                      // time in update()
+
+static void timed_update( AudioStream *a ){
+std::chrono::steady_clock::time_point t0;
+
+   t0 = std::chrono::steady_clock::now();
+   a->update();
+   ns += std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - t0 ).count();
+}
+
+static void hash_add( int32_t v ){
+int i;
+
+   for( i = 0; i < 4; ++i ){
+      hash ^= ( v >> ( 8 * i )) & 0xff;
+      hash *= 16777619u;
+   }
+}
+
+static void hash_block( AudioStream *a, int ch ){
+int i;
+
+   if( a->sent[ch] == 0 ) return;
+   a->sent[ch] = 0;
+   for( i = 0; i < AUDIO_BLOCK_SAMPLES; ++i ) hash_add( a->out[ch].data[i] );
+}
+
+static audio_block_t *block( int16_t *dat ){
+audio_block_t *b;
+
+   b = new audio_block_t;
+   memcpy( b->data, dat, sizeof( b->data ));
+   return b;
+}
+
+// made up input, 1 khz and 2.3 khz tones, a -600 hz carrier, noise, and an impulse every 37 blocks
+static void make_input(){
+uint32_t seed = 12345;
+double ph1 = 0, ph2 = 0, ph3 = 0;
+double i, q;
+int b, n, r;
+
+   for( b = 0; b < BLOCKS; ++b ){
+      for( n = 0; n < AUDIO_BLOCK_SAMPLES; ++n ){
+         i = 3000 * cos( ph1 ) + 1500 * cos( ph2 ) + 2000 * cos( ph3 );
+         q = 3000 * sin( ph1 ) + 1500 * sin( ph2 ) + 2000 * sin( ph3 );
+         ph1 += 2 * PI * 1000 / AUDIO_SAMPLE_RATE_EXACT;
+         ph2 += 2 * PI * 2300 / AUDIO_SAMPLE_RATE_EXACT;
+         ph3 -= 2 * PI * 600 / AUDIO_SAMPLE_RATE_EXACT;
+         seed = seed * 1664525u + 1013904223u;
+         r = (int16_t)( seed >> 16 ) >> 5;
+         i += r;
+         q -= r;
+         if( b % 37 == 5 && n == 64 ) i += 20000, q -= 20000;
+         src_i[b][n] = constrain( (int)i, -32768, 32767 );
+         src_q[b][n] = constrain( (int)q, -32768, 32767 );
+      }
+   }
+}
+
+// 16 bit stereo wav, I left and Q right
+static int read_wav( const char *name ){
+FILE *f;
+int16_t s[2];
+char hdr[44];
+int b, n;
+
+   f = fopen( name, "rb" );
+   if( f == 0 ) return 0;
+   if( fread( hdr, 1, 44, f ) != 44 || memcmp( hdr, "RIFF", 4 )) return fclose( f ), 0;
+   for( b = 0; b < BLOCKS; ++b ){
+      for( n = 0; n < AUDIO_BLOCK_SAMPLES; ++n ){
+         if( fread( s, 2, 2, f ) != 2 ) break;
+         src_i[b][n] = s[0];
+         src_q[b][n] = s[1];
+      }
+      if( n < AUDIO_BLOCK_SAMPLES ) break;
+   }
+   fclose( f );
+   return b;
+}
+
+struct BENCH {
+   const char *name;
+   uint32_t golden;
+   void (*run)( int b );               // feed block b, run update, hash the outputs
+};
+
+static AudioMagPhase1 mp;
+static AudioWeaver1 wv_usb, wv_sam;
+static AudioAGC1 agc;
+static AudioNotchLMS1 notch;
+static AudioNoiseBlank1 nb;
+static AudioCWDet1 cwdet;
+static AudioFFT_IQ1 fft;
+static AudioNoiseReduce1 nr;
+static AudioCWSkim1 skim;
+
+static void run_magphase( int b ){
+int32_t m = 0, p = 0;
+
+   mp.in[0] = block( src_q[b] );
+   timed_update( &mp );
+   while( mp.level() > 8 ) mp.read( &m, &p ), hash_add( m ), hash_add( p );
+}
+
+static void run_weaver( AudioWeaver1 *w, int b ){
+
+   w->in[0] = block( src_i[b] );
+   w->in[1] = block( src_q[b] );
+   timed_update( w );
+   hash_block( w, 0 );
+   hash_block( w, 1 );
+}
+
+static void run_wv_usb( int b ){ run_weaver( &wv_usb, b ); }
+static void run_wv_sam( int b ){ run_weaver( &wv_sam, b ); }
+
+static void run_agc( int b ){
+
+   agc.in[0] = block( src_i[b] );
+   timed_update( &agc );
+   hash_block( &agc, 0 );
+   hash_add( agc.read_gain() );
+}
+
+static void run_notch( int b ){
+
+   notch.in[0] = block( src_i[b] );
+   timed_update( &notch );
+   hash_block( &notch, 0 );
+}
+
+static void run_nb( int b ){
+
+   nb.in[0] = block( src_i[b] );
+   nb.in[1] = block( src_q[b] );
+   timed_update( &nb );
+   hash_block( &nb, 0 );
+   hash_block( &nb, 1 );
+}
+
+static void run_cwdet( int b ){
+
+   cwdet.in[0] = block( src_i[b] );
+   timed_update( &cwdet );
+   while( cwdet.available() ) hash_add( cwdet.read() );
+}
+
+static void run_fft( int b ){
+int i;
+
+   fft.in[0] = block( src_i[b] );
+   fft.in[1] = block( src_q[b] );
+   timed_update( &fft );
+   if( fft.available() ) for( i = 0; i < 256; ++i ) hash_add( fft.read( i ));
+}
+
+static void run_nr( int b ){
+
+   nr.in[0] = block( src_i[b] );
+   timed_update( &nr );
+   hash_block( &nr, 0 );
+}
+
+static void run_skim( int b ){
+uint16_t mag[SKIM_CHANNELS];
+int i;
+
+   skim.in[0] = block( src_i[b] );
+   timed_update( &skim );
+   while( skim.available() ){
+      skim.read( mag );
+      for( i = 0; i < SKIM_CHANNELS; ++i ) hash_add( mag[i] );
+   }
+}
+
+static struct BENCH bench[] = {
+   { "MagPhase",  0x57252c5d, run_magphase },
+   { "WeaverUSB", 0xcbc0d775, run_wv_usb },
+   { "WeaverSAM", 0x650e1aba, run_wv_sam },
+   { "AGC",       0x36d1d435, run_agc },
+   { "Notch",     0xdf099de5, run_notch },
+   { "NB",        0x383434b7, run_nb },
+   { "CWdet",     0x7e4eabba, run_cwdet },
+   { "FFT_IQ",    0xc0e36e28, run_fft },
+   { "NR",        0x0ccd6cd4, run_nr },
+   { "Skimmer",   0xceec036c, run_skim }
+};
+#define NUM_BENCH ( sizeof( bench ) / sizeof( bench[0] ))
+
+static void setup(){
+
+   mp.setrate( 6 );
+   mp.setmode( 1 );
+   wv_usb.weaver( 3000 );
+   wv_usb.sideband( WEAVER_USB );
+   wv_usb.bandwidth( 200, 3000, 0 );
+   wv_sam.weaver( 3000 );
+   wv_sam.sideband( WEAVER_SAM );
+   wv_sam.bandwidth( 100, 3600, 0 );
+   agc.level( 4000 );
+   agc.maxgain( 8.0 );
+   notch.rate( 5 );
+   nb.level( 5 );
+   cwdet.frequency( 1000 );
+   fft.setrate( 1 );
+   fft.setmode( 1 );
+   nr.strength( 5 );
+   skim.setmode( 1 );
+}
+
+int main( int argc, char **argv ){
+unsigned int i;
+int b, gen, wav, fails;
+
+   gen = ( argc > 1 && strcmp( argv[1], "-g" ) == 0 );
+   wav = ( argc > 1 && gen == 0 );
+   if( wav ){
+      nblocks = read_wav( argv[1] );
+      if( nblocks == 0 ) return printf( "can't read %s\n", argv[1] ), 2;
+   }
+   else make_input();
+   setup();
+
+   fails = 0;
+   for( i = 0; i < NUM_BENCH; ++i ){
+      hash = 2166136261u;
+      ns = 0;
+      for( b = 0; b < nblocks; ++b ) bench[i].run( b );
+      printf( "%-10s %8.0f ns/block  %08x", bench[i].name, ns / nblocks, hash );
+      if( gen || wav ) printf( "\n" );
+      else if( hash == bench[i].golden ) printf( "  ok\n" );
+      else printf( "  FAIL, expected %08x\n", bench[i].golden ), ++fails;
+   }
+   return fails != 0;
+}
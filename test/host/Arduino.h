@@ -0,0 +1,38 @@
+// Host stand-in for the parts of the Teensy core that the audio objects use.  For the tests in test/ only.
+
+#ifndef Arduino_h_
+#define Arduino_h_
+
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <stdio.h>
+
+#define PI 3.1415926535897932384626433832795
+#define constrain(a,l,h) ((a)<(l)?(l):((a)>(h)?(h):(a)))
+#define max(a,b) ((a)>(b)?(a):(b))
+#define min(a,b) ((a)<(b)?(a):(b))
+
+typedef uint8_t byte;
+
+class String                           // enough for FrameBuf::print( String ), holds the pointer only
+{
+public:
+   String( const char *p = "" ) : s( p ){}
+   unsigned int length() const { return strlen( s ); }
+   void toCharArray( char *buf, unsigned int n ) const {
+      if( n == 0 ) return;
+      strncpy( buf, s, n - 1 );
+      buf[n-1] = 0;
+   }
+private:
+   const char *s;
+};
+
+#define ARM_DWT_CYCCNT  0              // DSP_TIMER reads nothing on the host
+
+static inline void __disable_irq(){}
+static inline void __enable_irq(){}
+
+#endif
@@ -0,0 +1,47 @@
+// Host stand-in for the Teensy audio library AudioStream.  The test puts a block on each input with in[], calls
+// update(), and finds what was transmitted in out[] with sent[] set.  Blocks come from new and go back with release().
+
+#ifndef AudioStream_h_
+#define AudioStream_h_
+
+#include <stdint.h>
+#include <string.h>
+
+#define AUDIO_BLOCK_SAMPLES      128
+#define AUDIO_SAMPLE_RATE_EXACT  44117.64706f
+#define AUDIO_SAMPLE_RATE        AUDIO_SAMPLE_RATE_EXACT
+#define AUDIO_MAX_CH             4
+
+typedef struct audio_block_struct {
+   int16_t data[AUDIO_BLOCK_SAMPLES];
+} audio_block_t;
+
+class AudioStream
+{
+public:
+   AudioStream( unsigned char ninput, audio_block_t **iqueue ){
+      memset( in, 0, sizeof( in ));
+      memset( sent, 0, sizeof( sent ));
+   }
+   virtual void update( void ) = 0;
+
+   audio_block_t *in[AUDIO_MAX_CH];                // set by the test, taken by receive
+   audio_block_t out[AUDIO_MAX_CH];
+   int sent[AUDIO_MAX_CH];
+
+protected:
+   audio_block_t *receiveReadOnly( unsigned int i = 0 ){
+      audio_block_t *b = in[i];
+      in[i] = 0;
+      return b;
+   }
+   audio_block_t *receiveWritable( unsigned int i = 0 ){ return receiveReadOnly( i ); }
+   static audio_block_t *allocate( void ){ return new audio_block_t; }
+   static void release( audio_block_t *b ){ delete b; }
+   void transmit( audio_block_t *b, unsigned char i = 0 ){
+      out[i] = *b;
+      sent[i] = 1;
+   }
+};
+
+#endif
@@ -0,0 +1,99 @@
+// Host stand-in for the CMSIS-DSP radix 4 complex FFTs that FFT_IQ, NoiseReduce and CWSkim use.  A reference radix 4
+// decimation in frequency with the CMSIS scaling, each of the log4(N) stages divides by 4 so both directions come out
+// 1/N, and the bit reversal puts the bins in natural order.  Not bit exact with the Teensy library, the dsp_bench
+// golden hashes for those three objects are for this version.
+
+#ifndef arm_math_h_
+#define arm_math_h_
+
+#include <stdint.h>
+#include <math.h>
+
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+
+typedef struct {
+   uint16_t fftLen;
+   uint8_t ifftFlag;
+   uint8_t bitReverseFlag;
+} arm_cfft_radix4_instance_q15;
+
+typedef struct {
+   uint16_t fftLen;
+   uint8_t ifftFlag;
+   uint8_t bitReverseFlag;
+} arm_cfft_radix4_instance_q31;
+
+static inline int arm_cfft_radix4_init_q15( arm_cfft_radix4_instance_q15 *s, uint16_t n, uint8_t ifft, uint8_t rev ){
+   s->fftLen = n;  s->ifftFlag = ifft;  s->bitReverseFlag = rev;
+   return 0;
+}
+
+static inline int arm_cfft_radix4_init_q31( arm_cfft_radix4_instance_q31 *s, uint16_t n, uint8_t ifft, uint8_t rev ){
+   s->fftLen = n;  s->ifftFlag = ifft;  s->bitReverseFlag = rev;
+   return 0;
+}
+
+// T is the sample type, Q the twiddle fraction bits, W a wide enough type for the products
+template <typename T, int Q, typename W>
+static inline void host_cfft_radix4( T *x, int n, int ifft, int rev ){
+int n1, n2, i, j, k, i1, i2, i3;
+W ar, ai, br, bi, cr, ci, dr, di, t0r, t0i, t1r, t1i, t2r, t2i, t3r, t3i, yr, yi;
+W wr[3], wi[3];
+double a;
+T tmp;
+
+   for( n2 = n; n2 > 1; ){
+      n1 = n2;
+      n2 >>= 2;
+      for( j = 0; j < n2; ++j ){
+         for( k = 0; k < 3; ++k ){                   // W^j, W^2j, W^3j at this stage
+            a = 2 * M_PI * ( k + 1 ) * j / n1;
+            wr[k] = (W)lround( cos( a ) * ( ( (W)1 << Q ) - 1 ));
+            wi[k] = (W)lround( ( ifft ? 1 : -1 ) * sin( a ) * ( ( (W)1 << Q ) - 1 ));
+         }
+         for( i = j; i < n; i += n1 ){
+            i1 = i + n2;  i2 = i1 + n2;  i3 = i2 + n2;
+            ar = (W)x[2*i] >> 2;   ai = (W)x[2*i+1] >> 2;
+            br = (W)x[2*i1] >> 2;  bi = (W)x[2*i1+1] >> 2;
+            cr = (W)x[2*i2] >> 2;  ci = (W)x[2*i2+1] >> 2;
+            dr = (W)x[2*i3] >> 2;  di = (W)x[2*i3+1] >> 2;
+            t0r = ar + cr;  t0i = ai + ci;
+            t1r = ar - cr;  t1i = ai - ci;
+            t2r = br + dr;  t2i = bi + di;
+            t3r = br - dr;  t3i = bi - di;
+            if( ifft ) t3r = -t3r, t3i = -t3i;
+            x[2*i] = (T)( t0r + t2r );                // outputs 0 2 1 3 in the slots, so plain bit reversal sorts them
+            x[2*i+1] = (T)( t0i + t2i );
+            yr = t0r - t2r;  yi = t0i - t2i;
+            x[2*i1] = (T)(( yr * wr[1] - yi * wi[1] ) >> Q );
+            x[2*i1+1] = (T)(( yr * wi[1] + yi * wr[1] ) >> Q );
+            yr = t1r + t3i;  yi = t1i - t3r;
+            x[2*i2] = (T)(( yr * wr[0] - yi * wi[0] ) >> Q );
+            x[2*i2+1] = (T)(( yr * wi[0] + yi * wr[0] ) >> Q );
+            yr = t1r - t3i;  yi = t1i + t3r;
+            x[2*i3] = (T)(( yr * wr[2] - yi * wi[2] ) >> Q );
+            x[2*i3+1] = (T)(( yr * wi[2] + yi * wr[2] ) >> Q );
+         }
+      }
+   }
+   if( rev == 0 ) return;
+   for( i = 0, j = 0; i < n; ++i ){
+      if( i < j ){
+         tmp = x[2*i];  x[2*i] = x[2*j];  x[2*j] = tmp;
+         tmp = x[2*i+1];  x[2*i+1] = x[2*j+1];  x[2*j+1] = tmp;
+      }
+      for( k = n >> 1; j & k; k >>= 1 ) j ^= k;
+      j |= k;
+   }
+}
+
+static inline void arm_cfft_radix4_q15( const arm_cfft_radix4_instance_q15 *s, q15_t *x ){
+   host_cfft_radix4<q15_t, 15, int64_t>( x, s->fftLen, s->ifftFlag, s->bitReverseFlag );
+}
+
+static inline void arm_cfft_radix4_q31( const arm_cfft_radix4_instance_q31 *s, q31_t *x ){
+   host_cfft_radix4<q31_t, 31, __int128>( x, s->fftLen, s->ifftFlag, s->bitReverseFlag );
+}
+
+#endif
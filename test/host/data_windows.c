@@ -0,0 +1,23 @@
+// The 256 point Hanning window from the Teensy audio library data_windows.c, for FFT_IQ and CWSkim in the host tests.
+// Regenerated as 32767 * ( 1 - cos( 2 pi n / 255 )) / 2, rounded.
+
+#include <stdint.h>
+
+const int16_t AudioWindowHanning256[] __attribute__ ((aligned (4))) = {
+       0,     5,    20,    45,    80,   124,   179,   243,   317,   401,   495,   598,   711,   833,   965,  1106,
+    1257,  1416,  1585,  1763,  1949,  2145,  2349,  2561,  2782,  3011,  3249,  3494,  3747,  4008,  4276,  4552,
+    4834,  5124,  5421,  5724,  6034,  6350,  6672,  7000,  7334,  7673,  8018,  8367,  8722,  9081,  9444,  9812,
+   10184, 10559, 10938, 11321, 11706, 12094, 12485, 12879, 13274, 13671, 14070, 14470, 14872, 15274, 15677, 16081,
+   16484, 16888, 17291, 17694, 18096, 18497, 18897, 19295, 19691, 20085, 20477, 20867, 21254, 21638, 22019, 22396,
+   22770, 23139, 23505, 23866, 24223, 24575, 24922, 25264, 25601, 25932, 26257, 26576, 26889, 27195, 27495, 27789,
+   28075, 28354, 28626, 28891, 29148, 29397, 29638, 29871, 30096, 30313, 30521, 30721, 30912, 31094, 31267, 31432,
+   31587, 31732, 31869, 31996, 32114, 32222, 32320, 32409, 32488, 32557, 32617, 32666, 32706, 32736, 32756, 32766,
+   32766, 32756, 32736, 32706, 32666, 32617, 32557, 32488, 32409, 32320, 32222, 32114, 31996, 31869, 31732, 31587,
+   31432, 31267, 31094, 30912, 30721, 30521, 30313, 30096, 29871, 29638, 29397, 29148, 28891, 28626, 28354, 28075,
+   27789, 27495, 27195, 26889, 26576, 26257, 25932, 25601, 25264, 24922, 24575, 24223, 23866, 23505, 23139, 22770,
+   22396, 22019, 21638, 21254, 20867, 20477, 20085, 19691, 19295, 18897, 18497, 18096, 17694, 17291, 16888, 16484,
+   16081, 15677, 15274, 14872, 14470, 14070, 13671, 13274, 12879, 12485, 12094, 11706, 11321, 10938, 10559, 10184,
+    9812,  9444,  9081,  8722,  8367,  8018,  7673,  7334,  7000,  6672,  6350,  6034,  5724,  5421,  5124,  4834,
+    4552,  4276,  4008,  3747,  3494,  3249,  3011,  2782,  2561,  2349,  2145,  1949,  1763,  1585,  1416,  1257,
+    1106,   965,   833,   711,   598,   495,   401,   317,   243,   179,   124,    80,    45,    20,     5,     0
+};
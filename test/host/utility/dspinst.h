@@ -0,0 +1,37 @@
+// Host versions of the Cortex-M4 DSP instructions from the Teensy audio library utility/dspinst.h
+
+#ifndef dspinst_h_
+#define dspinst_h_
+
+#include <stdint.h>
+
+// ssat, saturate to bits after the shift
+static inline int32_t signed_saturate_rshift( int32_t val, int bits, int rshift ){
+int32_t lim = ( 1 << ( bits - 1 )) - 1;
+
+   val >>= rshift;
+   if( val > lim ) return lim;
+   if( val < -lim - 1 ) return -lim - 1;
+   return val;
+}
+
+static inline int32_t saturate16( int32_t val ){ return signed_saturate_rshift( val, 16, 0 ); }
+
+// smmul and smmulr
+static inline int32_t multiply_32x32_rshift32( int32_t a, int32_t b ){ return ( (int64_t)a * b ) >> 32; }
+static inline int32_t multiply_32x32_rshift32_rounded( int32_t a, int32_t b ){
+   return ( (int64_t)a * b + 0x80000000LL ) >> 32;
+}
+
+// smulwb
+static inline int32_t signed_multiply_32x16b( int32_t a, uint32_t b ){ return ( (int64_t)a * (int16_t)b ) >> 16; }
+
+// pkhbt, a in the top half
+static inline uint32_t pack_16b_16b( int32_t a, int32_t b ){ return ( (uint32_t)a << 16 ) | ( (uint32_t)b & 0xffff ); }
+
+// smuad
+static inline int32_t multiply_16tx16t_add_16bx16b( uint32_t a, uint32_t b ){
+   return (int16_t)( a >> 16 ) * (int16_t)( b >> 16 ) + (int16_t)a * (int16_t)b;
+}
+
+#endif
@@ -0,0 +1,307 @@
+// I2C traffic on the host.  The Si5351 code and the frame buffer run against i2start, i2send and i2stop stubs that time
+// stamp each frame on a model of the bus, 9 bits a byte with the address plus start and stop at the configured clock,
+// and charge it to a feature the way the #I CAT command does.  For each tx rate and mode there are tuning steps, a band
+// change, a full OLED frame buffer flush, and one second of EER transmit with the MagPhase object on test audio.  The
+// EER interrupt is played at its tick rate, freq_calc_fast and queue_pllb when dp changes, and the I2C done interrupt
+// starts the next queued frame when the one on the bus ends.  #I gives the same counts from the radio.
+//
+//   i2c_sim             table at the 800k clock that i2init sets
+//   i2c_sim -c 600000   at another clock
+//   i2c_sim -v          also list every frame with its start time, us from the start of the run
+
+#include <stdio.h>
+#include "Arduino.h"
+#include "AudioStream.h"
+#include "../MagPhase.h"
+#include "../FrameBuf.h"
+
+#define I2F_QSY    0                   // features, as in usdx_t32.ino
+#define I2F_BAND   1
+#define I2F_EER    2
+#define I2F_DISP   3
+#define I2F_OTHER  4
+#define I2F_N      5
+
+#define OLED_ADDR  0x3C
+
+static const char *names[I2F_N] = { "qsy", "band", "EER", "disp", "other" };
+
+struct I2_USE {
+   long frames, bytes;
+   double us;
+};
+static struct I2_USE use[I2F_N];
+
+static double clk = 800000;
+static int verbose;
+static double now;                     // us, time of the code that is running
+static double bus_free;                // end of the last frame put on the bus
+static int feature = I2F_OTHER;        // like i2_tag, the EER run sets I2F_EER as the interrupt does
+static int cur, nbytes, cur_adr;
+static double t_start;
+
+static void eer_frame_done( double end );
+
+void i2start( unsigned char adr ){
+
+   t_start = ( now > bus_free ) ? now : bus_free;      // waits for the last frame, Wire.done()
+   cur = ( adr == OLED_ADDR ) ? I2F_DISP : feature;
+   cur_adr = adr;
+   nbytes = 1;                                         // address byte
+}
+
+void i2send( unsigned int data ){
+
+   ++nbytes;
+}
+
+void i2stop(){
+double us;
+
+   us = ( 9 * nbytes + 3 ) * 1000000.0 / clk;
+   bus_free = t_start + us;
+   ++use[cur].frames;
+   use[cur].bytes += nbytes;
+   use[cur].us += us;
+   if( verbose ) printf( "%12.1f  %-5s 0x%02x %3d bytes %7.1f us\n", t_start, names[cur], cur_adr, nbytes, us );
+   if( cur == I2F_EER ) eer_frame_done( bus_free );
+}
+
+int rit_enabled;
+
+#include "../si5351_usdx.cpp"
+
+static SI5351 si;
+
+#define AM   0                         // modes, as in usdx_t32.ino
+#define USB  1
+#define LSB  2
+#define CW   3
+#define DIGI 4
+#define UDSB 5
+#define LDSB 6
+
+static const char *mode_names[] = { "AM", "USB", "LSB", "CW", "DIGI", "UDSB", "LDSB" };
+#define NUM_MODES 7
+
+#define CW_OFFSET      700
+#define WEAVER_SAM_HZ  1000
+#define QSY_STEPS      10              // encoder steps of 100 hz, 20 ms apart
+
+static int mode, bfo;
+
+static int mode_bfo( int m ){          // half the weaver width that set_bandwidth picks
+
+   if( m == CW ) return 2500/2;
+   if( m == AM || m == DIGI ) return 6000/2;
+   return 4000/2;
+}
+
+// qsy() and band_change() in usdx_t32.ino, without the display and bandstack parts
+static void qsy( uint32_t f, uint16_t d ){
+
+   switch( mode ){
+      case AM:  f += WEAVER_SAM_HZ;  break;
+      case CW:  f += CW_OFFSET;                // no break
+      case LDSB:
+      case LSB: f -= bfo;  break;
+      case USB:
+      case UDSB:
+      case DIGI: f += bfo;  break;
+   }
+   si.freq( f, 0, 90, d );
+   if( mode == CW && rit_enabled == 0 ){
+      si.freq_calc_fast( -CW_OFFSET + bfo );
+      si.SendPLLBRegisterBulk();
+   }
+}
+
+static void band_change( uint32_t f, uint16_t d ){
+
+   si.shadow_clear();
+   qsy( f, d );                                // from mode_change, set_bandwidth
+   si.SendRegister( 177, 0xA0 );
+}
+
+static void oled_out( int row, int col, uint8_t *dat, int n ){     // the receive path of oled_out()
+uint8_t cmd[6];
+int i;
+
+   cmd[0] = 0x21;  cmd[1] = col;  cmd[2] = 127;                    // SSD1306 column and page address
+   cmd[3] = 0x22;  cmd[4] = row;  cmd[5] = 7;
+   i2start( OLED_ADDR );
+   i2send( 0 );
+   for( i = 0; i < 6; ++i ) i2send( cmd[i] );
+   i2stop();
+   i2start( OLED_ADDR );
+   i2send( 0x40 );
+   while( n-- ) i2send( *dat++ );
+   i2stop();
+}
+
+static FrameBuf OLD( 128, 8 );
+
+// EER transmit.  Ticks come every tx_rate audio samples and the mic audio goes to MagPhase a block at a time.
+static AudioMagPhase1 mp;
+static double frame_tick[SIQ_SIZE];    // tick that queued each frame
+static double worst;                   // longest from a tick to the end of its frame
+
+static void eer_frame_done( double end ){
+
+   if( end - frame_tick[si.q_tail] > worst ) worst = end - frame_tick[si.q_tail];
+}
+
+static void bus_run( double t ){       // the I2C done interrupt for every frame that ends before t
+
+   while( si.q_busy && bus_free <= t ){
+      now = bus_free;
+      si.queue_start();
+   }
+}
+
+static audio_block_t *mic_block( int b ){
+audio_block_t *blk;
+double t;
+int n;
+
+   blk = new audio_block_t;
+   for( n = 0; n < AUDIO_BLOCK_SAMPLES; ++n ){
+      t = (double)( b * AUDIO_BLOCK_SAMPLES + n ) / AUDIO_SAMPLE_RATE_EXACT;
+      if( mode == DIGI ) blk->data[n] = lround( 12000 * sin( 2 * PI * 1500 * t ));
+      else blk->data[n] = lround( 8000 * sin( 2 * PI * 700 * t ) + 8000 * sin( 2 * PI * 1900 * t ));
+   }
+   return blk;
+}
+
+static void eer_run( int rate ){
+double tick, blk_us, t;
+int32_t m, p, prev_phase, rav_mag, rav_dp, dp, last_dp;
+int ua, k, ticks, b, tx_stat;
+
+   ua = mp.setrate( rate );
+   mp.setmode(( mode == AM || mode == LDSB || mode == UDSB ) ? 2 : 1 );
+   tick = 1000000.0 * rate / AUDIO_SAMPLE_RATE_EXACT;
+   blk_us = 1000000.0 * AUDIO_BLOCK_SAMPLES / AUDIO_SAMPLE_RATE_EXACT;
+   ticks = AUDIO_SAMPLE_RATE_EXACT / rate;
+   prev_phase = rav_mag = rav_dp = tx_stat = b = 0;
+   last_dp = -1;
+   t = max( now, bus_free ) + 1000;            // tx() waits out the display flush and a 1 ms delay
+
+   for( k = 0; k < ticks; ++k, t += tick ){
+      while( b * blk_us <= k * tick ){
+         mp.in[0] = mic_block( b++ );
+         mp.update();
+      }
+      bus_run( t );
+      now = t;
+      if( mp.available() == 0 ){
+         last_dp = -1;
+         continue;
+      }
+      if( mp.read( &m, &p ) == 0 ) continue;
+
+      rav_mag = ( 27853 * rav_mag + 4915 * m ) >> 15;
+      dp = p - prev_phase;
+      prev_phase = p;
+      if( mode == DIGI ){                      // eer_digi
+         if( dp < 0 ) dp += ua;
+         if( dp > 3200 ) dp = rav_dp;
+         rav_dp = ( 27853 * rav_dp + 4940 * dp ) >> 15;
+         dp = rav_dp - bfo;
+      }
+      else if( mode == USB || mode == LSB ){   // eer_ssb, phase_delay -1 only delays the magnitude
+         if( dp < -ua/2 ) dp += ua;
+         frame_tick[si.q_head] = t;
+         if(( rav_mag >> 5 ) < 40 ){
+            if( tx_stat == 1 ) tx_stat = 0, si.queue_reg( 3, 0b11111111 );
+         }
+         else if( tx_stat == 0 ) tx_stat = 1, si.queue_reg( 3, 0b11111011 );
+         dp = ( mode == USB ) ? dp - bfo : -dp + bfo;
+      }
+      else if( mode == AM ) dp = -2500;        // eer_am
+      else if( mode == UDSB ) dp = -bfo;
+      else dp = bfo;
+
+      dp = constrain( dp, -3200, 3200 );
+      if( last_dp != dp ){
+         si.freq_calc_fast( dp );
+         frame_tick[si.q_head] = t;
+         si.queue_pllb();
+         last_dp = dp;
+      }
+   }
+   bus_run( 1e30 );
+   now = t;
+}
+
+static const struct {                  // bandstack[] in usdx_t32.ino, 40m and 20m
+   uint32_t f;
+   uint16_t d;
+} b40 = { 7163000, 100 }, b20 = { 14074000, 54 };
+
+// one line of the table, every feature for a tx rate and mode
+static int run( int rate, int m ){
+double us_s;
+int i;
+
+   memset( use, 0, sizeof( use ));
+   now = bus_free = 0;
+   mode = m;
+   bfo = mode_bfo( m );
+
+   feature = I2F_OTHER;                        // start up on 40m, not counted
+   band_change( b40.f, b40.d );
+
+   feature = I2F_QSY;
+   for( i = 1; i <= QSY_STEPS; ++i ){
+      now += 20000;
+      qsy( b40.f + 100 * i, b40.d );
+   }
+
+   feature = I2F_BAND;
+   now += 20000;
+   band_change( b20.f, b20.d );
+
+   now += 20000;
+   OLD.begin( oled_out );                      // every byte dirty
+   OLD.flush_all();
+
+   feature = I2F_EER;
+   si.queue_clear();
+   worst = 0;
+   if( m != CW ) eer_run( rate );
+   feature = I2F_OTHER;
+
+   us_s = use[I2F_EER].us;                     // bus us in the 1 second of transmit
+   printf( "%4d %-4s |%6ld %6.0f |%6ld %6.0f |%6ld %6.0f |%7ld %6ld %7.0f %5.1f%% %6.1f %4d %4d\n",
+           rate, mode_names[m],
+           use[I2F_QSY].bytes, use[I2F_QSY].us, use[I2F_BAND].bytes, use[I2F_BAND].us,
+           use[I2F_DISP].bytes, use[I2F_DISP].us,
+           use[I2F_EER].frames, use[I2F_EER].bytes, us_s, us_s / 10000.0, worst, si.q_late, si.q_drops );
+   return si.q_drops;
+}
+
+int main( int argc, char **argv ){
+int i, rate, m, drops;
+
+   for( i = 1; i < argc; ++i ){
+      if( strcmp( argv[i], "-v" ) == 0 ) verbose = 1;
+      else if( strcmp( argv[i], "-c" ) == 0 && i + 1 < argc ) clk = atof( argv[++i] );
+      else return printf( "usage: i2c_sim [-v] [-c clock]\n" ), 2;
+   }
+
+   printf( "I2C clock %.0f, qsy is %d steps of 100 hz, EER is 1 second of transmit, us are bus time\n",
+           clk, QSY_STEPS );
+   printf( "          |%13s |%13s |%13s |%s\n", "qsy", "band", "disp", "      EER" );
+   printf( "rate mode |%6s %6s |%6s %6s |%6s %6s |%7s %6s %7s %6s %6s %4s %4s\n", "bytes", "us", "bytes", "us",
+           "bytes", "us", "frames", "bytes", "us", "busy", "worst", "late", "drop" );
+   drops = 0;
+   for( rate = 4; rate <= 6; ++rate ){
+      for( m = 0; m < NUM_MODES; ++m ){
+         i = run( rate, m );
+         if( rate == 6 ) drops += i;           // the default tx_rate has to keep up
+      }
+   }
+   if( drops ) printf( "FAIL %d EER frames dropped at tx rate 6\n", drops );
+   return drops != 0;
+}
@@ -0,0 +1,87 @@
+// freq_calc_fast against the 64 bit divide it replaced.  For each crystal and divider, freq() is run on a spread of
+// frequencies to set up _msb128 and _dfk, then every offset the EER interrupt can ask for, -3200 to 3200 Hz, is put
+// through freq_calc_fast and the old formula.  The PLLB register bytes must be the same for all of them.  Dividers are
+// the band table ones on their bands, then every even divider over the vco range.
+
+#include <stdio.h>
+#include "Arduino.h"
+
+void i2start( unsigned char c ){}
+void i2send( unsigned int data ){}
+void i2stop(){}
+int rit_enabled;
+
+#include "../si5351_usdx.cpp"
+
+#define DF_MAX 3200
+
+static SI5351 si;
+
+static const uint32_t xtals[] = { 27003380, 27004300, 27000000, 25004000, 25000000, 20004000 };
+
+static const struct {                  // bandstack[] in usdx_t32.ino
+   uint32_t lo, hi;
+   uint16_t d;
+} bands[] = {
+   {  3500000,  4000000, 126 }, {  5330000,  5410000, 126 }, {  7000000,  7300000, 100 },
+   { 10100000, 10150000,  68 }, { 14000000, 14350000,  54 }, { 18068000, 18168000,  40 },
+   { 21000000, 21450000,  34 }, { 24890000, 24990000,  30 }, { 28000000, 29700000,  26 }
+};
+#define NUM_BANDS ( sizeof( bands ) / sizeof( bands[0] ))
+
+static void old_regs( int16_t df, uint8_t *r ){
+uint32_t msb128, msp1, msp2;
+
+   msb128 = si._msb128 + ((int64_t)( si._div * (int32_t)df ) * _MSC * 128 ) / si.fxtal;
+   msp1 = si._msa128min512 + msb128 / _MSC;
+   msp2 = msb128 % _MSC;
+   r[3] = BB1( msp1 );
+   r[4] = BB0( msp1 );
+   r[5] = (( _MSC & 0xF0000 ) >> ( 16 - 4 )) | BB2( msp2 );
+   r[6] = BB1( msp2 );
+   r[7] = BB0( msp2 );
+}
+
+static long checks, fails;
+
+// every offset at one frequency
+static void check( uint32_t f, uint16_t d ){
+uint8_t want[8];
+int df, i;
+
+   si.freq( f, 0, 90, d );
+   for( df = -DF_MAX; df <= DF_MAX; ++df ){
+      si.freq_calc_fast( df );
+      old_regs( df, want );
+      ++checks;
+      for( i = 3; i < 8; ++i ) if( si.pll_regs[i] != want[i] ) break;
+      if( i == 8 ) continue;
+      if( ++fails <= 10 ) printf( "FAIL xtal %u f %u d %u df %d\n", (unsigned)si.fxtal, (unsigned)f, d, df );
+   }
+}
+
+int main(){
+unsigned int x, b;
+uint32_t f, seed = 1;
+int d, n;
+
+   for( x = 0; x < sizeof( xtals ) / sizeof( xtals[0] ); ++x ){
+      si.fxtal = xtals[x];
+      for( b = 0; b < NUM_BANDS; ++b ){
+         for( n = 0; n < 64; ++n ){
+            seed = seed * 1664525u + 1013904223u;
+            check( bands[b].lo + seed % ( bands[b].hi - bands[b].lo ), bands[b].d );
+         }
+      }
+      for( d = 4; d <= 254; d += 2 ){                // vco 400 to 900 MHz, fout over the 3.5 MHz _div limit
+         for( n = 0; n < 4; ++n ){
+            seed = seed * 1664525u + 1013904223u;
+            f = ( 400000000u + seed % 500000000u ) / d;
+            if( f < 3500000 || f > 30000000 ) continue;
+            check( f, d );
+         }
+      }
+   }
+   printf( "%ld offsets checked, %ld differ\n", checks, fails );
+   return fails != 0;
+}
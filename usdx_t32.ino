@@ -90,6 +90,76 @@
  *    Version 1.56  Have SSB voice working well.  Moved tx_drive back to the TxSelect mux and implemented audio clipping.  Did not like how              
  *                  the audio clipping sounded and added ALC.  Can now run the mic gain double what is was before and still have a nice
  *                  sounding signal.  Added a FIR filter after the TxSelect mux for clip filtering and more anti alias filtering. 
+ *    Version 1.57  Added DSP_BENCH option that prints the cycles used per audio block by each custom audio object.  Judging DSP
+ *                  changes by the cpu number on the screen was not catching blocks that ran over the 3ms budget.
+ *                  The Hilberts in MagPhase and FFT_Scope now process a whole block with the dual 16 bit MAC instructions instead
+ *                  of shifting the 31 tap delay line on every sample.
+ *                  Replaced the Goertzel band scope with a 256 point complex FFT of I and Q.  Both sides of the vfo update
+ *                  together about 40 times a second instead of sweeping one bin at a time, and the display is plotted a
+ *                  few columns per loop pass.  FFT_Scope moved to the saved folder.
+ *                  The EER interrupt no longer skips PLLB writes when the I2C bus is busy.  Frames go in a queue in the
+ *                  SI5351 class and the I2C done interrupt sends the next one.  Ovr on the tx status now counts frames that
+ *                  were queued late or dropped.
+ *                  The TX decimation rate is now a multi function knob setting, 4 5 or 6.  The TXLow FIR moved into
+ *                  MagPhase as a polyphase decimator that only computes the samples that are kept.
+ *                  MagPhase phase and magnitude from a 12 step cordic, MP_CORDIC in MagPhase.cpp.  No divide in the
+ *                  transmit path and the phase error is about 1 count in 7352 where arctan3 was off by up to 6.
+ *                  MagPhase hands off mag and phase through a ring with head and tail indexes.  EER starts when the ring
+ *                  fills to a target level and a PI controller on eer_time holds it there, so audio to RF delay is fixed.
+ *                  New AGC audio object after the BandWidth filter.  Block peak envelope with attack, hang and decay in ms
+ *                  and one block of look ahead.  agc1 and agc2 are now just the RF gain setting.  No more float AGC in loop.
+ *                  USB IQ menu.  IQ rec sends the raw adc I and Q to the computer as stereo.  IQ play receives from USB
+ *                  audio instead of the adc's, so recorded band conditions can be run through the Weaver receiver again.
+ *                  CAT commands #P and #R read and clear a cpu profile.  Audio object cycles per block, EER interrupt worst
+ *                  case time and jitter from the DWT cycle counter, loop() time, I2C queue and MagPhase ring counters.
+ *                  OLD and LCD are now framebuffers ( FrameBuf.h ).  Printing only changes memory, and loop sends each page's
+ *                  changed column range in one burst.  An S meter or scope column that did not change sends nothing.
+ *                  I2C arbiter.  PLLB frames are the real time lane, OLED writes during transmit are a best effort lane
+ *                  that only uses the measured time left before the next EER tick.  The OLED shows ALC and a drive bar
+ *                  while transmitting and tx drive can be adjusted with the knob.
+ *                  CW skimmer on the Decode Screen menu.  The Skimmer object decimates the Weaver audio by 8 and runs a 64
+ *                  point FFT every 8.7ms, 16 channels 86 hz apart from 431 hz.  Each channel has its own level tracker and
+ *                  read behind decoder, the decoder state moved into struct CW_READ.  The latest channels are shown one
+ *                  per line and CAT #K sends the text of all of them.
+ *                  CW decode screen decoder now runs on every 2.9ms audio block.  CWdet is a new fixed point Goertzel object
+ *                  in place of the tone detect.  The dit dah split comes from a histogram of mark lengths, and letters
+ *                  are looked up directly in a 256 entry reverse morse table.  Was unreliable above 30 wpm.
+ *                  Noise reduction object after the BandWidth filter, NR on the multi function knob, 0 is off.  Spectral
+ *                  subtraction at 1/4 rate with a 64 point integer FFT.  Decimate4.h has the filters to go down and back up.
+ *                  Noise blanker on the raw I and Q ahead of agc1 and agc2, NB on the multi function knob.  Impulses over a
+ *                  multiple of the average I Q magnitude are zeroed, starting 6 samples early with a look ahead delay.
+ *                  LMS auto notch ahead of BandWidth, Notch on the multi function knob sets the convergence rate.  Runs at
+ *                  1/4 rate and only the carrier it predicts is brought back up and subtracted.  Off in CW and DIGI.
+ *                  The notched frequency shows on the right of row 3.
+ *                  Receive runs at 1/4 rate.  The Weaver object decimates I and Q to 11k and does the roofing lowpass,
+ *                  complex BFO, sideband add or subtract, AM envelope and BandWidth filter in one place, then interpolates
+ *                  back up.  ILow, the BFO sines, the mixers, AMdet, SSB and BandWidth are gone, QLow is just the mic filter.
+ *                  The Notch now follows the BandWidth filter, and the skimmer takes the Weaver audio ahead of it.
+ *                  QLow is disconnected on receive so the mic biquads only run on voice transmit.  The Decimate4 filters
+ *                  run two taps per instruction with the dual 16 bit MAC, same outputs as before.
+ *                  AM is now a synchronous detector in the Weaver object.  The carrier NCO is phase locked with a frequency
+ *                  loop to pull it in, AM tunes 1k off instead of 2.5k.  SAM sb on the multi function knob picks both,
+ *                  upper or lower sideband.  S and the carrier offset on the left of row 3 when locked.
+ *                  Receive and mic filter coefficients are constexpr tables made by the compiler ( FilterBank.h ), no more
+ *                  float filter design on a filter, mode or tone change.  Weaver swaps in a new set at the next block and
+ *                  fades out the old filter over that block.  Tone keeps its 0.02 steps, 41 settings in the table.
+ *                  SI5351 keeps a shadow of the chip registers and freq() sends only the bytes that changed, in bursts.  A
+ *                  tuning step with the same divider skips the multisynth, clock and phase registers, about 6 bytes
+ *                  in place of 56.
+ *                  I2C traffic accounting.  Frames, bytes and bus time for qsy, band change, EER and the display, and
+ *                  the EER share of the bus while transmitting.  CAT #I reports it, #R clears it.  test/i2c_sim
+ *                  plays the same traffic on the host for each tx rate and mode.
+ *                  freq_calc_fast in the EER interrupt uses a scale worked out in freq() in place of a 64 bit divide.
+ *                  CAT replies go through a ring that is sent a USB packet at a time from loop.  Added a Kenwood TS-480
+ *                  command subset next to the Argo V emulation, FA FB IF MD TX RX SM ID AI PS FR FT.
+ *                  loop() is a small scheduler.  Tasks in priority order with periods and deadlines, one task per pass
+ *                  so the 1ms keyer tick isn't held up by the display, missed ticks are caught up, and the cpu sleeps
+ *                  when nothing is due.  CAT #T reports runs, late starts and worst case cycles of each task.
+ *                  The encoder is read on every loop pass outside the table, and there is no sleep during EER transmit,
+ *                  WFI stops the DWT cycle counter the I2C gap timing depends on.
+ *                  DSP_BENCH counts are exact.  Our audio objects time update() with the DWT counter ( DspCycles.h ),
+ *                  library objects use the library's 64 cycle count instead of a whole percent.  test/ has a host build
+ *                  of the audio objects that checks their output against golden hashes, run make in test.
  *                 
  *                  
  *                  
@@ -97,7 +167,7 @@
  *             
  */
 
-#define VERSION 1.56
+#define VERSION 1.57
 
 // Paddle jack has Dah on the Tip and Dit on Ring.  Swap probably needed for most paddles.
 // Mic should have Mic on Tip, PTT on Ring for this radio.
@@ -193,6 +263,7 @@
 
                                       
 #define DEBUG_MP  0                  // This is for testing the EER transmitter, and printing to arduino plotter.  Set 0 for normal use.
+#define DSP_BENCH 0                  // Prints audio object cycles per block once a second on Serial.  Conflicts with CAT, set 0 for normal use.
 //#define TWO_TONE_TEST                // comment this out for normal use
                               
 
@@ -209,10 +280,16 @@
 
 #include <i2c_t3.h>            // non-blocking wire library
 #include "MagPhase.h"          // transmitting audio object
-#include "AM_decode.h"         // the simplest complex IQ decoder that I tried
+#include "Weaver.h"            // weaver receiver at 1/4 rate
+#include "NotchLMS.h"          // auto notch for carriers
+#include "NoiseBlank.h"        // impulse blanker on raw I and Q
+#include "NoiseReduce.h"       // spectral subtraction at 11k
+#include "AGC.h"               // block AGC with look ahead
 #include "my_morse.h"          // my morse table, designed for sending but used also for receive
-#include "FFT_Scope.h"         // A simple FFT type of display using a Goertzel filter.
-#include "ParksLPF36.h"        // Transmit bandwidth filter
+#include "FFT_IQ.h"            // complex FFT band scope
+#include "CWDet.h"             // cw tone envelope per audio block
+#include "CWSkim.h"            // channelized CW decoder front end
+#include "FrameBuf.h"          // off screen display copy, only the changed bytes are sent
 
 
 
@@ -229,12 +306,16 @@ extern unsigned char MediumNumbers[];
 #define ROW6  48
 #define ROW7  56          // OLED has two more text rows
 
+// The display code writes to LCD and OLD framebuffers.  Loop sends the changed bytes to the hardware a page at a time.
 #ifdef USE_LCD
    //   ( sclk mosi d/c rst cs )
-   LCD5110 LCD( 13,11,9,8,10 );
+   LCD5110 LCDhw( 13,11,9,8,10 );
+   FrameBuf LCD( 84, 6 );
 #endif
 #ifdef USE_OLED
-   OLED1306 OLD;
+   OLED1306 OLDhw;
+   #define OLED_ADDR 0x3C
+   FrameBuf OLD( 128, 8 );
 #endif
 
 // transmit interval timer
@@ -261,7 +342,7 @@ IntervalTimer EER_timer;
 int encoder_user;
 
 // volume users - general use of volume code
-#define MAX_VUSERS 8
+#define MAX_VUSERS 13
 #define VOLUME_U   0
 #define AGC_GAIN_U 1
 #define CW_DET_U   2
@@ -270,14 +351,26 @@ int encoder_user;
 #define TONE_U      5
 #define TX_DRIVE_U  6
 #define TX_PHASE_U  7
+#define TX_RATE_U   8
+#define NR_U        9
+#define NB_U       10
+#define NOTCH_U    11
+#define SAM_U      12
 int multi_user;
 
 // screen users of the bottom part not used by freq display and status line
 #define INFO 0
 #define CW_DECODE 1
 #define FFT_SCOPE 2
+#define CW_SKIM 3
 int screen_user = INFO;
 
+// usb audio out and rx source.  Record raw adc I and Q to usb, or replay them from usb into the receiver.
+#define USB_AUDIO  0
+#define USB_IQREC  1
+#define USB_IQPLAY 2
+int usb_io = USB_AUDIO;
+
 #define MIC 0
 #define USBc 1        // universal serial bus, conflicts with upper side band def USB, so be careful here.  
 #define SIDETONE 2 
@@ -341,17 +434,19 @@ int trigger_;                  // !!! testing for debug using arduino plotter
 int step_timer;                // allows double tap to backup the freq step to 500k , command times out
                                // and returns to the normal double tap command ( volume )
 float af_gain = 0.3;
-float agc_gain = 1.0;
+float agc_gain = 1.0;          // now a manual RF gain, agc1 and agc2 no longer move with the signal
 float side_gain = 0.1;         // side tone volume, also af_gain affects side tone volume. agc_gain doesn't.
-float sig_rms;
 int transmitting;
 float cw_det_val = 1.3;        // mark space detect, adjust in volume options ( double tap, single tap )
-float agc_sig = 0.3;           // made global so can set it after tx and have rx process bring up the af gain
 int attn2;                     // attenuator using T/R switch, very large decrease in volume
 int wpm = 14;                  // keyer speed, adjust with "Volume" routines
 float tone_;                   // tone control, adjust Q of the bandwidth object
 float tx_drive = 7.0;          // Adjust for some ALC action on normal voice. For my mic and voice, 4.0 is about right for no ALC.
                                // and use this for the microphone level only
+int nr_strength;                // noise reduction 0 off to 10
+int nb_level;                   // noise blanker 0 off to 10
+int notch_rate;                 // auto notch convergence 0 off to 10, used in the voice modes
+int sam_sb;                     // synchronous AM sidebands, 0 both, 1 upper, 2 lower
 int phase_delay = -1;          // sample delay between modulation change and phase change, -7 to 7
 float alc = 1.0;               // tx ALC when using the microphone
 
@@ -368,7 +463,13 @@ int touch_key = 1;           // 0 !!!
 int cw_practice = 1;
 int key_swap = 1;              // jack wired with tip = DAH, needs swap from most of my other radio's
 
-#define stage(c) Serial.write(c)
+// CAT replies go to a ring.  radio_control() flushes it from loop, as much as the USB packet buffer will take in one
+// write, and sends the packet when the ring is empty.  Nothing waits on the host, a full ring drops the byte.
+#define CAT_OUT 1024                   // power of 2, holds the longest report
+char cat_buf[CAT_OUT];
+uint16_t cat_in, cat_out;
+uint32_t cat_drops;
+#define stage(c) cat_put(c)
 
 /******************************** Teensy Audio Library **********************************/ 
 
@@ -386,69 +487,73 @@ AudioAnalyzePeak         peak1;          //xy=428.5714416503906,211.142858982086
 AudioAmplifier           agc2;           //xy=473.5714416503906,378.1428589820862
 AudioAmplifier           agc1;           //xy=476.5714416503906,328.1428589820862
 AudioInputUSB            usb2;           //xy=477.1428565979004,516.8571624755859
-AudioFilterFIR           TXLow;           //xy=487.1428909301758,477.14284324645996
 AudioFilterBiquad        QLow;           //xy=503.28573989868164,427.1428394317627
-AudioFilterBiquad        ILow;           //xy=513.5714416503906,275.1428589820862
-AudioFFT_Scope2          Scope2;         //xy=545.7142857142857,98.57142857142856
+AudioFFT_IQ1             IQscope;        //xy=545.7142857142857,98.57142857142856
 AudioMixer4              TxSelect;       //xy=653.5714416503906,512.1428589820862
-AudioSynthWaveformSine   sinBFO;         //xy=657.5714416503906,374.1428589820862
-AudioSynthWaveformSine   cosBFO;         //xy=659.5714416503906,337.1428589820862
-AudioEffectMultiply      Q_mixer;        //xy=691.5714416503906,430.1428589820862
-AudioAMdecode2           AMdet;         //xy=694.2857398986816,230.00000190734863
-AudioEffectMultiply      I_mixer;        //xy=694.5714416503906,281.1428589820862
-AudioAnalyzeToneDetect   Scope_det4;     //xy=726.1427993774414,139.9999542236328
-AudioAnalyzeToneDetect   Scope_det2;     //xy=727.571403503418,71.42853736877441
-AudioAnalyzeToneDetect   Scope_det3;     //xy=727.5713348388672,105.71429061889648
-AudioAnalyzeToneDetect   Scope_det1;     //xy=728.9999542236328,38.571428298950195
+AudioWeaver1             Weaver;         // demodulator and bandwidth filter at 11k
 AudioSynthWaveformSine   SideTone;       //xy=848.5714416503906,414.1428589820862
 AudioMagPhase1           MagPhase;         //xy=848.5714874267578,521.4285278320312
-AudioMixer4              SSB;            //xy=864.5714416503906,345.1428589820862
-AudioFilterBiquad        BandWidth;      //xy=981.5714416503906,271.1428589820862
-AudioAnalyzeRMS          rms1;           //xy=1030.5714416503906,216.14285898208618
+AudioNotchLMS1           Notch;          // after the bandwidth filter
+AudioNoiseReduce1        NR;             // ahead of the agc
+AudioAGC1                agc;            //xy=1030.5714416503906,216.14285898208618
 AudioMixer4              Volume;         //xy=1058.5714416503906,345.1428589820862
 AudioAmplifier           amp1;           //xy=1144.5714416503906,269.1428589820862
-AudioAnalyzeToneDetect   CWdet;          //xy=1188.5714416503906,206.14285898208618
+AudioCWDet1              CWdet;          //xy=1188.5714416503906,206.14285898208618
 AudioOutputAnalog        dac1;           //xy=1198.7142753601074,332.8571243286133
 AudioOutputUSB           usb1;           //xy=1202.5714416503906,380.1428589820862
+AudioMixer4              RxSrcI;         // adc or usb replay
+AudioMixer4              RxSrcQ;
+AudioNoiseBlank1         NB;             // ahead of agc1 and agc2
+AudioMixer4              UsbL;           // audio or raw I and Q
+AudioMixer4              UsbR;
+AudioCWSkim1             Skimmer;        // cw decoder channels
 #ifdef TWO_TONE_TEST
   AudioSynthWaveformSine   SideTone2;      //xy=483.14290618896484,555.7143478393555
   AudioConnection          patchCord9(SideTone2, 0, TxSelect, 3);
 #endif
 AudioConnection          patchCord1(adcs1, 0, peak1, 0);
-AudioConnection          patchCord2(adcs1, 0, agc1, 0);
-AudioConnection          patchCord3(adcs1, 0, Scope2, 0);
-AudioConnection          patchCord4(adcs1, 1, agc2, 0);
-AudioConnection          patchCord5(adcs1, 1, Scope2, 1);
+AudioConnection          patchCord2(RxSrcI, 0, NB, 0);
+AudioConnection          patchCord3(RxSrcI, 0, IQscope, 0);
+AudioConnection          patchCord4(RxSrcQ, 0, NB, 1);
+AudioConnection          patchCord46(NB, 0, agc1, 0);
+AudioConnection          patchCord47(NB, 1, agc2, 0);
+AudioConnection          patchCord5(RxSrcQ, 0, IQscope, 1);
+AudioConnection          patchCord36(adcs1, 0, RxSrcI, 0);
+AudioConnection          patchCord37(usb2, 0, RxSrcI, 1);
+AudioConnection          patchCord38(adcs1, 1, RxSrcQ, 0);
+AudioConnection          patchCord39(usb2, 1, RxSrcQ, 1);
 AudioConnection          patchCord6(agc2, QLow);
-AudioConnection          patchCord7(agc1, ILow);
+AudioConnection          patchCord7(agc1, 0, Weaver, 0);
+AudioConnection          patchCord10(agc2, 0, Weaver, 1);
 AudioConnection          patchCord8(usb2, 0, TxSelect, 1);
 //AudioConnection          patchCord9(SideTone2, 0, TxSelect, 3);
-AudioConnection          patchCord10(QLow, 0, Q_mixer, 0);
-AudioConnection          patchCord11(QLow, 0, AMdet, 1);
 AudioConnection          patchCord12(QLow, 0, TxSelect, 0);
-AudioConnection          patchCord13(ILow, 0, I_mixer, 0);
-AudioConnection          patchCord14(ILow, 0, AMdet, 0);
-AudioConnection          patchCord15(Scope2, Scope_det1);
-AudioConnection          patchCord16(Scope2, Scope_det2);
-AudioConnection          patchCord17(Scope2, Scope_det3);
-AudioConnection          patchCord18(Scope2, Scope_det4);
-AudioConnection          patchCord19(TxSelect, TXLow);
-AudioConnection          patchCord20(sinBFO, 0, Q_mixer, 1);
-AudioConnection          patchCord21(cosBFO, 0, I_mixer, 1);
-AudioConnection          patchCord22(Q_mixer, 0, SSB, 2);
-AudioConnection          patchCord23(AMdet, 0, SSB, 0);
-AudioConnection          patchCord24(I_mixer, 0, SSB, 1);
-AudioConnection          patchCord25(TXLow, 0, MagPhase, 0);
+AudioConnection          patchCord19(TxSelect, 0, MagPhase, 0);
 AudioConnection          patchCord26(SideTone, 0, Volume, 3);
 AudioConnection          patchCord27(SideTone, 0, TxSelect, 2);
-AudioConnection          patchCord28(SSB, BandWidth);
-AudioConnection          patchCord29(BandWidth, 0, Volume, 0);
-AudioConnection          patchCord30(BandWidth, rms1);
-AudioConnection          patchCord31(BandWidth, amp1);
+AudioConnection          patchCord28(Weaver, 0, Notch, 0);
+AudioConnection          patchCord45(Notch, NR);
+AudioConnection          patchCord29(NR, agc);
+AudioConnection          patchCord30(agc, 0, Volume, 0);
+AudioConnection          patchCord31(agc, amp1);
 AudioConnection          patchCord32(Volume, dac1);
-AudioConnection          patchCord33(Volume, 0, usb1, 0);
-AudioConnection          patchCord34(Volume, 0, usb1, 1);
+AudioConnection          patchCord33(Volume, 0, UsbL, 0);
+AudioConnection          patchCord34(Volume, 0, UsbR, 0);
 AudioConnection          patchCord35(amp1, CWdet);
+AudioConnection          patchCord40(adcs1, 0, UsbL, 1);
+AudioConnection          patchCord41(adcs1, 1, UsbR, 1);
+AudioConnection          patchCord42(UsbL, 0, usb1, 0);
+AudioConnection          patchCord43(UsbR, 0, usb1, 1);
+AudioConnection          patchCord44(Weaver, 1, Skimmer, 0);
+
+// QLow is the TX mic filter, cut dc and 60 hz hum and the highs.  Coefficients made by the compiler.
+static constexpr WV_COEF mic_stages[4] = {
+  fb_biquad( 300, 0.54119610, 1, AUDIO_SAMPLE_RATE_EXACT ),
+  fb_biquad( 300, 1.3065630, 1, AUDIO_SAMPLE_RATE_EXACT ),
+  fb_biquad( 2800, 0.54119610, 0, AUDIO_SAMPLE_RATE_EXACT ),
+  fb_biquad( 2800, 1.3065630, 0, AUDIO_SAMPLE_RATE_EXACT )
+};
+static constexpr FB_TEENSY mic_filter( mic_stages );
 
 
 /*  
@@ -563,6 +668,42 @@ AudioConnection          patchCord30(amp1, CWdet);
 */
 
 // I2C functions that the OLED library expects to use.
+void i2done();
+uint32_t i2_byte_cycles;             // cpu cycles for one byte with ack on the bus
+
+// I2C traffic accounting for the #I CAT command.  Every frame is charged to a feature: OLED frames to the display,
+// Si5351 frames started in an interrupt to EER, and the rest to the tag set by qsy() or band_change().  Bus time is
+// worked out from the bytes at the configured clock, 9 bits a byte plus start and stop.
+#define I2F_QSY    0
+#define I2F_BAND   1
+#define I2F_EER    2
+#define I2F_DISP   3
+#define I2F_OTHER  4
+#define I2F_N      5
+struct I2_USE {
+  uint32_t frames, bytes, bits;
+};
+volatile struct I2_USE i2_use[I2F_N];
+volatile int i2_tag = I2F_OTHER;
+int i2_cur, i2_n;                    // feature and length of the frame being built
+uint32_t i2_since;                   // millis() at the last #R
+uint32_t i2_tx_ms, i2_tx_start;      // transmit time since then
+
+int i2_tag_push( int tag ){          // outer callers keep their tag, band_change calls qsy
+int old;
+
+   old = i2_tag;
+   if( old == I2F_OTHER ) i2_tag = tag;
+   return old;
+}
+
+static inline int in_interrupt(){
+uint32_t ipsr;
+
+   __asm__ volatile( "mrs %0, ipsr" : "=r" (ipsr) );
+   return ipsr != 0;
+}
+
 void i2init(){
 
   Wire.begin(I2C_OP_MODE_DMA);   // use mode DMA or ISR 
@@ -574,22 +715,35 @@ void i2init(){
                              // At 1/6 rate get some errors at 700k. Use 800k. Should have better TX quality at 1/6 rate.
                              // At 1/5 rate get some errors at 1000k.  Think we should stay at 1/6 rate, ( 1/6 of 44117 )
                              // and 800k clock on I2C.
+  Wire.onTransmitDone( i2done ); // transmit register queue runs from the I2C interrupt
+  Wire.onError( i2error );
+  i2_byte_cycles = F_CPU / ( Wire.getClock() / 9 );
 }
 
 void i2start( unsigned char adr ){
 
   while( Wire.done() == 0 );         // still busy with last transmission.  Need to block while still busy.
   Wire.beginTransmission( adr );
+  #ifdef OLED_ADDR
+    if( adr == OLED_ADDR ) i2_cur = I2F_DISP;
+    else
+  #endif
+  i2_cur = in_interrupt() ? I2F_EER : i2_tag;
+  i2_n = 1;                          // address byte
 
 }
 
 void i2send( unsigned int data ){ 
 
   Wire.write( data );
+  ++i2_n;
 }
 
 void i2stop( ){
   Wire.sendTransmission();     // non-blocking
+  ++i2_use[i2_cur].frames;
+  i2_use[i2_cur].bytes += i2_n;
+  i2_use[i2_cur].bits += 9 * i2_n + 3;
  // Wire.endTransmission();      // blocking
 }
 
@@ -600,21 +754,26 @@ void i2stop( ){
 SI5351 si5351;                 // maybe it should be done this way.
 
 
+
 // the transmit process uses I2C in an interrupt context.  Must prevent other users from writing on I2C.  
-// No frequency changes or any OLED writes.  transmitting variable is used to disable large parts of the system.
-#define DRATE 6                      // decimation rate used in MagPhase
-#define F_SAMP_TX (44117/DRATE)      // ! setting _UA and sample rate the same, removed scaling calculation
-#define _UA (44117/DRATE)            // match definition in MagPhase.cpp
+// No frequency changes.  OLED writes go through the best effort lane of the I2C arbiter below.
+// transmitting variable is used to disable large parts of the system.
+int tx_rate = 6;                     // decimation rate used in MagPhase, 4 5 or 6.  Needs I2C to keep up at 4.
+int eer_ua = 44117/6;                // ! setting _UA and sample rate the same, removed scaling calculation. From MagPhase.
 
-int eer_count;
 int eer_mode;
 //int temp_count;          // !!! debug
-int eer_adj;             // !!! debug
-int overs;               // I2C not ready for the next set of register data
 // int saves;               // short write bulk
 // float eer_time = 90.680;  //90.668;  // us for each sample deci rate 4
 float eer_time = 136.0;  // 1/6 rate ( 1/6 of 44117 )
 //float eer_time = 113.335;   // 1/5 rate
+float eer_nominal = 136.0;          // set from tx_rate at the start of transmit
+float eer_integ;                    // rate controller integral, kept between transmits
+int eer_integ_rate;                 // tx_rate that eer_integ was learned at
+
+#define EER_CTL_N  128              // EER samples averaged for each rate correction, the ring level is a sawtooth
+#define EER_KP   0.02               // us per sample of level error
+#define EER_KI   0.0005
 
 struct EER {
     int32_t m;           // in mag and phase
@@ -623,8 +782,129 @@ struct EER {
     int32_t dp;
 };
  
-void EER_function(){     // EER transmit interrupt function.  Interval timer.
-int c;
+// DWT cycle counter profile of the EER interrupt, read with the #P CAT command and cleared with #R
+uint32_t eer_cycles_max;             // worst case time in EER_function
+uint32_t eer_period_min = 0xffffffff;    // time between interrupts, max - min is the jitter
+uint32_t eer_period_max;
+volatile uint32_t eer_last;          // cycle count at the last interrupt, 0 to restart the period measurement
+volatile int eer_on;                 // EER timer is running, best effort I2C must fit between its ticks
+
+
+// I2C arbiter.  The si5351 queue is the real time lane, EER queues PLLB frames and the I2C done interrupt sends them.
+// Display traffic while transmitting is a best effort lane.  When the real time lane is empty, the done interrupt
+// measures the time left until the next EER tick and sends as much of the next best effort frame as will finish
+// before it, the rest waits for the next gap.  A frame is split by resending the address and control byte, the OLED
+// keeps its column pointer between transfers.  si5351.q_busy is set while either lane has the bus.
+#define I2BE_SIZE    8              // frames, power of 2
+#define I2BE_DATA   32              // max bytes per frame after the control byte
+#define I2BE_MARGIN  2              // byte times kept free before the next EER tick
+
+struct I2BE_FRAME {
+   uint8_t adr;
+   uint8_t ctl;                     // OLED control byte, 0 commands, 0x40 data
+   uint8_t n;
+   uint8_t pos;                     // bytes already sent
+   uint8_t data[I2BE_DATA];
+};
+struct I2BE_FRAME i2be_frame[I2BE_SIZE];
+volatile uint8_t i2be_head, i2be_tail;
+volatile uint32_t i2be_parts;       // counters for the #P profile
+volatile uint32_t i2be_waits;       // gaps too short to send anything
+
+int i2be_room(){ return I2BE_SIZE - 1 - (( i2be_head - i2be_tail ) & ( I2BE_SIZE - 1 )); }
+
+void i2be_start(){                  // call with the bus idle, from the I2C done interrupt or with interrupts off
+struct I2BE_FRAME *f;
+uint32_t used, period;
+int i, n;
+
+   if( i2be_tail == i2be_head ) return;
+   f = &i2be_frame[i2be_tail];
+   n = f->n - f->pos;
+   if( eer_on ){                                // fit in the gap before the next EER tick
+      if( eer_last == 0 ) return;               // no tick yet, nothing to measure from
+      used = ARM_DWT_CYCCNT - eer_last;
+      period = eer_time * ( F_CPU / 1000000 );
+      i = ( used < period ) ? ( period - used ) / i2_byte_cycles - I2BE_MARGIN - 2 : 0;  // less address and control
+      if( i <= 0 ){
+         ++i2be_waits;
+         return;
+      }
+      if( n > i ) n = i;
+   }
+
+   si5351.q_busy = 1;
+   i2start( f->adr );
+   i2send( f->ctl );
+   for( i = 0; i < n; ++i ) i2send( f->data[f->pos + i] );
+   i2stop();
+   ++i2be_parts;
+   f->pos += n;
+   if( f->pos >= f->n ) i2be_tail = ( i2be_tail + 1 ) & ( I2BE_SIZE - 1 );
+}
+
+void i2done(){                      // I2C done interrupt, real time lane first
+  si5351.queue_start();
+  if( si5351.q_busy == 0 ) i2be_start();
+}
+
+void i2error(){                     // a frame failed, the Si5351 may not hold what the shadow says
+  if( i2_cur != I2F_DISP ) si5351.shadow_clear();
+  i2done();
+}
+
+// queue a best effort write from loop.  More than I2BE_DATA bytes go as several frames, the OLED keeps its pointer.
+// Waits if the lane is full, check i2be_room() first when EER is running.
+void i2be_post( uint8_t adr, uint8_t ctl, uint8_t *dat, int n ){
+struct I2BE_FRAME *f;
+int i, k;
+
+   while( n > 0 ){
+      while( i2be_room() == 0 );
+      k = ( n > I2BE_DATA ) ? I2BE_DATA : n;
+      f = &i2be_frame[i2be_head];
+      f->adr = adr;  f->ctl = ctl;  f->n = k;  f->pos = 0;
+      for( i = 0; i < k; ++i ) f->data[i] = dat[i];
+      dat += k;
+      n -= k;
+      i2be_head = ( i2be_head + 1 ) & ( I2BE_SIZE - 1 );
+
+      noInterrupts();                            // the done interrupt must not start a frame between test and start
+      if( si5351.q_busy == 0 && Wire.done() ) i2be_start();
+      interrupts();
+   }
+}
+
+// wait for both lanes to empty, used on return to receive when the gaps are no longer measured
+void i2be_flush(){
+
+   while( i2be_tail != i2be_head ){
+      noInterrupts();
+      if( si5351.q_busy == 0 && Wire.done() ) i2be_start();
+      interrupts();
+   }
+   si5351.queue_flush();
+}
+
+void EER_function(){     // wrapper for the profile counters
+uint32_t t0, t;
+
+   t0 = ARM_DWT_CYCCNT;
+   if( eer_last ){
+      t = t0 - eer_last;
+      if( t < eer_period_min ) eer_period_min = t;
+      if( t > eer_period_max ) eer_period_max = t;
+   }
+   eer_last = t0;
+   eer_process();
+   __disable_irq();                      // no PLLB frame this tick, the whole period is free for the display
+   if( si5351.q_busy == 0 && Wire.done() ) i2be_start();
+   __enable_irq();
+   t = ARM_DWT_CYCCNT - t0;
+   if( t > eer_cycles_max ) eer_cycles_max = t;
+}
+
+void eer_process(){      // EER transmit interrupt function.  Interval timer.
 // static int prev_phase;
 static int last_dp;
 // static int dline[8];     // phase change delay
@@ -635,16 +915,17 @@ int dp;
 //static int mod;
 struct EER e;
 
-   if( MagPhase.available() == 0 ){       // start with 6 ms of buffered data( more now with 1/6 sample rate )
-      eer_count = 0;
+   if( MagPhase.available() == 0 ){       // wait for the ring to fill to its target level, fixes the latency
       last_dp = -1;
       return;
    }
 
    // process Mag and Phase
 
-   e.m = MagPhase.mvalue(eer_count);
-   e.p = MagPhase.pvalue(eer_count);
+   if( MagPhase.read( &e.m, &e.p ) == 0 ){            // underrun, hold the last output
+      eer_rate_control();
+      return;
+   }
    e.mag = 0;
    e.dp  = 0;
    
@@ -659,39 +940,13 @@ struct EER e;
    if( DEBUG_MP != 1 ) analogWrite( KEYOUT, mag );
 
    dp = constrain(e.dp, -3200, 3200 );
-   if( Wire.done() ){                                        // crash all:  can't wait for I2C while in ISR
-       if( last_dp != dp ){                                  // save I2C bandwidth if same dp as last time
-          si5351.freq_calc_fast(dp);
-          si5351.SendPLLBRegisterBulk();
-          last_dp = dp;                                
-       }
+   if( last_dp != dp ){                                      // save I2C bandwidth if same dp as last time
+      si5351.freq_calc_fast(dp);
+      si5351.queue_pllb();                                   // sent by the I2C interrupt when the bus is free
+      last_dp = dp;                                
    }
-   else ++overs;                                             //  Out of time on I2C bus, count skipped I2C transactions
  
-   ++eer_count;
-   eer_count &= ( AUDIO_BLOCK_SAMPLES - 1 );
-
-   // adjust timing.  MagPhase data counter reported will be 0, 32, 64, 96.
-   // we want to be reading out the data two blocks behind ( we decimated by 4, these blocks are 32 in length )
-   // testing at eer_count == zero, this test happens once per 12ms. 
-   // that is how it used to work.  Now decimating by 6 and each 3ms block of 128 results in 21 or 22 samples.
-   // So we are 3 blocks behind but that doesn't really matter for this sync routine.  We should still hit an index of 64 
-   // in the middle of the buffered data.  I2C couldn't keep up with decimation rates of 4 or 5, so using 6.
-   int u = 0;
-   if( eer_count == 0 ){
-      c = MagPhase.read_count();
-      //temp_count = c;               // !!! debug
-      //if( c == 64 ) ;                                      // two blocks delay is the goal
-      if( c < 64-8 ) eer_time += 0.0001, ++eer_adj, ++u;     // slow down  64-8 for 1/4 1/6 versions.  76-8 for 1/5 rate.
-      if( c > 64+8 ) eer_time -= 0.0001, --eer_adj, ++u;     // speed up    64-8 rates 1/4 and 1/6
-     // leak timer toward what we think is correct
-      if( eer_time > 136.01 ) eer_time -= 0.00001, ++u;   //  rate 1/6 version.    version at 1/4 rate use 90.67 to 90.68.
-      if( eer_time < 135.99 ) eer_time += 0.00001, ++u;
-      //if( eer_time > 113.34 ) eer_time -= 0.00001, ++u;     // rate 1/5 version
-      //if( eer_time < 113.33 ) eer_time += 0.00001, ++u;     // use 76 +-8 as index to sync
-      
-      if( u ) EER_timer.update( eer_time);
-   }
+   eer_rate_control();
 
     if( DEBUG_MP == 1 ){                             // serial writes in an interrupt function
        static int mod;                               // may cause other unintended issues.  Loss of sync maybe. 
@@ -709,6 +964,24 @@ struct EER e;
 }
 
 
+// PI rate controller.  Holds the MagPhase ring at its target level so the delay from audio to RF stays the same.
+// Was a fixed 0.0001 us nudge when the read index drifted out of a window plus a slow leak toward 136.0.
+// The integral learns the difference between the audio clock and the interval timer and is kept for the next transmit.
+void eer_rate_control(){
+static int n;
+static int32_t sum;
+float err;
+
+   sum += MagPhase.level();
+   if( ++n < EER_CTL_N ) return;
+   err = (float)( sum - n * MagPhase.target() ) / (float)n;     // average samples over target
+   n = sum = 0;
+   eer_integ += err;
+   eer_integ = constrain( eer_integ, -400.0, 400.0 );
+   eer_time = eer_nominal - EER_KP * err - EER_KI * eer_integ;  // more data than wanted, speed up
+   EER_timer.update( eer_time );
+}
+
 void eer_ssb( struct EER *e ){
 static int32_t prev_phase;
 static int dline[8];     // phase change delay
@@ -725,12 +998,12 @@ static int tx_stat;
    prev_phase = e->p;
    php = prev_phase;                            //  testing variable only
    
-   if( dp < -_UA/2 ) dp += _UA;
+   if( dp < -eer_ua/2 ) dp += eer_ua;
    // if( dp < -500 ) dp = 0;                // fail safe, some audio image is normal
    if( (rav_mag >> 5) < 40 ){                // avoid wideband hash when no audio to transmit 
-         if( tx_stat == 1 ) --overs, tx_stat = 0, si5351.SendRegister(3, 0b11111111);      // disable clock 2
+         if( tx_stat == 1 ) tx_stat = 0, si5351.queue_reg(3, 0b11111111);      // disable clock 2
    }
-   else if( tx_stat == 0 ) --overs, tx_stat = 1,  si5351.SendRegister(3, 0b11111011);      // Enable clock 2
+   else if( tx_stat == 0 ) tx_stat = 1,  si5351.queue_reg(3, 0b11111011);      // Enable clock 2
    
    
        // implement the delay line for phasing
@@ -772,8 +1045,8 @@ static int tx_stat;
    prev_phase = e->p;
    php = prev_phase;                            // !!! testing variable only
    
-   if( dp < -1000 ) dp += _UA;                   // allow some audio image to transmit, hilbert not perfect. -300
-   if( dp < _UA/2 ){                             // avoid sending any large positive spikes that result from previous statement
+   if( dp < -1000 ) dp += eer_ua;                   // allow some audio image to transmit, hilbert not perfect. -300
+   if( dp < eer_ua/2 ){                             // avoid sending any large positive spikes that result from previous statement
       if( (rav_mag >> 5) < 40 ){                // avoid wideband hash when no audio to transmit 
         // if( last_dp > 0 ) last_dp >>= 1;       // move toward a low level carrier at zero freq
         // if( last_dp < 0 ) ++last_dp;
@@ -824,7 +1097,7 @@ int dp;
    dp = e->p - prev_phase;
    prev_phase = e->p;
    php = prev_phase;                     // !!! testing printing phase
-   if( dp < 0 ) dp += _UA;
+   if( dp < 0 ) dp += eer_ua;
    if( dp > 3200 ) dp = rav_dp;
 
    rav_dp = 27853 * rav_dp + 4940 * dp;     // r/c time constant recursive filter .85 .15, increased gain from 4915 to be on frequency
@@ -860,6 +1133,9 @@ static int mod;
 void setup() {
    int contrast = 68;
 
+   ARM_DEMCR |= ARM_DEMCR_TRCENA;        // DWT cycle counter for the profile
+   ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+
    pinMode( KEYOUT, OUTPUT );
    digitalWriteFast( KEYOUT, LOW );
    //pinMode( RX, OUTPUT );
@@ -893,7 +1169,8 @@ void setup() {
    i2init();
 
    #ifdef USE_LCD
-    LCD.InitLCD(contrast);
+    LCDhw.InitLCD(contrast);
+    LCD.begin( lcd_out );
     LCD.setFont(SmallFont);
     LCD.print((char *)("Version "),0,ROW5);
     LCD.printNumF(VERSION,2,6*8,ROW5);
@@ -901,7 +1178,9 @@ void setup() {
    #endif
 
    #ifdef USE_OLED
-     OLD.InitLCD();
+     OLDhw.InitLCD();
+     OLDhw.write( 0, 0 );                  // close the library's open command transfer, oled_out sends its own
+     OLD.begin( oled_out );
      OLD.clrScr();
      OLD.setFont(SmallFont);
      OLD.print((char *)("Version "),0,ROW7);
@@ -910,6 +1189,7 @@ void setup() {
      //OLD.printNumI( Wire.getClock()/1000,0,ROW4);
    #endif
 
+   display_flush_all();
    delay( 4000 );        // jack wiring help screen will display
    #ifdef USE_LCD
      LCD.clrRow(0);
@@ -926,34 +1206,39 @@ void setup() {
   AudioNoInterrupts();
   AudioMemory(40);
   
-  SSB.gain(1,1.0);             // sub for USB
-  SSB.gain(2,-1.0);
-  SSB.gain(0,0.0);
-  SSB.gain(3,0.0);
+  Weaver.sideband( WEAVER_USB );
+  for( int i = 0; i < 4; ++i ) QLow.setCoefficients( i, mic_filter.k[i] );     // QLow is only the mic filter now
+  patchCord6.disconnect();                 // and only runs on voice transmit, see tx() and rx()
 
   set_tx_source();
 
   set_af_gain(af_gain);
   set_agc_gain(agc_gain);
+  set_usb_io();
   
   filter = 3;
   set_bandwidth();
-  CWdet.frequency(700,7);       // 600,6  1000,10 etc... aim for 10ms sample times.  Higher tones will be more accurate.(more samples)
+  CWdet.frequency(700);         // envelope every audio block
+  morse_rev_init();
+  cw_block_init();
   amp1.gain(10.0);              // more signal into the CW detector
-
-  Scope_det1.frequency(300);
-  Scope_det2.frequency(300*16);
-  Scope_det3.frequency(300*32);
-  Scope_det4.frequency(300*48);
+  agc.attack( AGC_ATTACK );
+  agc.hang( AGC_HANG );
+  agc.decay( AGC_DECAY );
+  agc.level( AGC_LEVEL );
 
   AudioInterrupts();
 
   if( screen_user == INFO ){
+    display_flush_all();
     delay( 2000 );              // let version stay on screen for 2 seconds
     menu_cleanup();             // erase and display again
     info_headers();
   }
-  if( screen_user == FFT_SCOPE ) Scope2.setmode( 1 );
+  if( screen_user == FFT_SCOPE ) IQscope.setmode( 1 );
+  skim_init();
+  if( screen_user == CW_SKIM ) Skimmer.setmode( 1 );
+  task_start();
 
 }
 
@@ -986,14 +1271,30 @@ int wv;                              // where we will put the weaver lowpass
    else if( mode == AM || mode == DIGI ) wv = 6000, hp = 100;      // for digi mode, set weaver hole at 3k hz
    else hp = 200, wv = 4000;                                       // SSB
 
-   BandWidth.setHighpass(0,hp,0.70710678);
-   BandWidth.setLowpass(1,bw,0.51763809 + tone_);
-   BandWidth.setLowpass(2,bw,0.70710678 + tone_);
-   BandWidth.setLowpass(3,bw,1.9318517 + tone_/2);
+   Weaver.bandwidth( hp, bw, lround( tone_ / WEAVER_TONE_Q ));      // table lookup, fades over 3ms
    
    set_Weaver_bandwidth(wv); 
 }
 
+// Unity gain mixers pass the samples through unchanged, so a recording replays bit for bit.
+// The mic comes in on the Q adc channel, so transmit always uses the adc.
+void set_usb_io(){
+int play, rec;
+
+   play = ( usb_io == USB_IQPLAY && transmitting == 0 );
+   rec = ( usb_io == USB_IQREC );
+   AudioNoInterrupts();
+     RxSrcI.gain( 0, play ? 0.0 : 1.0 );
+     RxSrcI.gain( 1, play ? 1.0 : 0.0 );
+     RxSrcQ.gain( 0, play ? 0.0 : 1.0 );
+     RxSrcQ.gain( 1, play ? 1.0 : 0.0 );
+     UsbL.gain( 0, rec ? 0.0 : 1.0 );
+     UsbL.gain( 1, rec ? 1.0 : 0.0 );
+     UsbR.gain( 0, rec ? 0.0 : 1.0 );
+     UsbR.gain( 1, rec ? 1.0 : 0.0 );
+   AudioInterrupts();
+}
+
 void set_attn2(){
 
    if( attn2 == 0 ){
@@ -1028,27 +1329,8 @@ void set_Weaver_bandwidth(int bandwidth){
   
   bfo = bandwidth/2;                       // weaver audio folding at 1/2 bandwidth
 
-  ILow.setLowpass(0,bfo,0.50979558);       // filters are set to 1/2 the desired audio bandwidth
-  ILow.setLowpass(1,bfo,0.60134489);       // with Butterworth Q's for 4 cascade
-  ILow.setLowpass(2,bfo,0.89997622);
-  ILow.setLowpass(3,bfo,2.5629154);
-
-  QLow.setLowpass(0,bfo,0.50979558);
-  QLow.setLowpass(1,bfo,0.60134489);
-  QLow.setLowpass(2,bfo,0.89997622);
-  QLow.setLowpass(3,bfo,2.5629154);
-
-  AudioNoInterrupts();                     // need so cos and sin start with correct phase
-
-    // complex BFO
-  cosBFO.amplitude(0.9);                   // amplitude 1.0 causes distortion ?
-  cosBFO.frequency(bfo);
-  cosBFO.phase(90);                        // cosine 
-  sinBFO.amplitude(0.9);
-  sinBFO.frequency(bfo);
-  sinBFO.phase(0);                         // sine
-
-  AudioInterrupts();
+  Weaver.weaver(bfo);                      // lowpass at 1/2 the desired audio bandwidth and the complex BFO, one
+                                           // phase accumulator so cos and sin can't get out of step
   qsy(freq);             // refresh Si5351 to new vfo frequency after weaver bandwidth changes
 
 }
@@ -1061,6 +1343,9 @@ void tx(){
   digitalWriteFast( RX, LOW );
   set_af_gain(0.0);                        // mute rx
   transmitting = 1;
+  i2_tx_start = millis();
+  set_usb_io();                            // mic needs the adc
+  NB.bypass( 1 );                          // don't blank the mic peaks
   si5351.SendRegister(3, 0b11111011);      // Enable clock 2, disable QSD
   if( rit_enabled == 0 ){                  // auto enable rit on transmit, cancel with long press encoder.
      rit_enabled = 1;                      // sort of like vfo B hidden, B = A on transmit. ( pllB, pllA ).
@@ -1068,6 +1353,7 @@ void tx(){
      freq_display();                       // show RIT in display
      status_display();                     // show new step size
   }
+  display_flush_all();                     // OLED must be up to date before the EER interrupt owns the I2C
   delay(1);                                // delay or wait for I2C done flag
   if( mode == CW ){
     pinMode(KEYOUT,OUTPUT);
@@ -1078,25 +1364,29 @@ void tx(){
     if( tx_source == MIC ){
        digitalWriteFast( TXAUDIO_EN, HIGH );           // enable tx audio through FET switch to A3 pin
        agc2.gain(0.98); 
-       QLow.setHighpass( 0,300,0.54119610 );           //  cut dc and 60 hz hum
-       QLow.setHighpass( 1,300,1.3065630);  
-       QLow.setLowpass( 2,2800,0.54119610);
-       QLow.setLowpass( 3,2800,1.3065630);
        //analogWriteFrequency(KEYOUT,44117);     // try same as sample rate, mic amp and D/A seem to alias PWM hash
        //analogWriteFrequency(KEYOUT,70312.5);
        // configured TX mux somewhere else in menu system, for microphone or usb source         
     }
     analogWriteFrequency(KEYOUT,70312.5);       // match 10 bits at 72mhz cpu clock. https://www.pjrc.com/teensy/td_pulse.html
 
-    TXLow.begin(TXLowc,36);                     // tx bandwidth fir filter
     analogWrite(KEYOUT,0);
     eer_mode = ( mode == AM || mode == LDSB || mode == UDSB) ? 2 : 1;     // 2 = AM or DSB controlled carrier voice 
+    eer_ua = MagPhase.setrate( tx_rate );
+    eer_nominal = 1000000.0 * tx_rate / 44117.0;
+    if( eer_integ_rate != tx_rate ) eer_integ = 0.0, eer_integ_rate = tx_rate;
+    eer_time = eer_nominal - EER_KI * eer_integ;  // start where the last transmit ended
+    patchCord6.connect();                       // mic filter in
     MagPhase.setmode(eer_mode);
+    si5351.queue_clear();                       // reset tx status counters
+    eer_last = 0;
+    eer_on = 1;
     EER_timer.begin(EER_function,eer_time);
   }
   
   tx_status(1);                            // clear row and print headers on LCD only
-  Scope2.setmode( 0 );                     // halt RX FFT
+  IQscope.setmode( 0 );                    // halt RX FFT
+  Skimmer.setmode( 0 );
 }
 
 void rx(){
@@ -1108,46 +1398,65 @@ void rx(){
   }
   else{
     EER_timer.end();
+    eer_on = 0;
     MagPhase.setmode(0);
-    TXLow.end();                           // turn off TX FIR filter
   }
   pinMode( KEYOUT, OUTPUT );               // either nointerrupts block or this line solved the double tx current on 2nd tx problem.
   digitalWriteFast( KEYOUT, LOW );         // do this after timer end or it will be turned on again 
   interrupts();
+  patchCord6.disconnect();                 // QLow has no input and skips its update, no biquads on receive.  Not in
+                                           // the block above, disconnect() turns interrupts back on
+  i2be_flush();                            // let the last queued frames go out before other I2C writes
+  if( transmitting ) i2_tx_ms += millis() - i2_tx_start;
   transmitting = 0;
-  /*saves = */ overs = 0;                       // reset tx status counters
+  set_usb_io();
+  NB.bypass( 0 );
   digitalWriteFast( TXAUDIO_EN, LOW );     // turn FET audio switch off if its on
   si5351.SendRegister(3, 0b11111111);      // disable all clocks
   #ifdef USE_LCD
      LCD.clrRow(0);
      status_display();
   #endif
-  set_bandwidth();                         // return Q filter bandwidth if used for tx, or just some redundant processing
+  set_bandwidth();                         // redundant processing, QLow stays the mic filter
   delay(1);                                // let the dust settle
   //pinMode( RX, INPUT );                  // use pullup to 5 volts. unless attn2 is enabled
   set_attn2();                             // use current attn2 setting for RX
   si5351.SendRegister(3, 0b11111100);      // enable rx clocks
   //delay(1);                                // !!! maybe needed for i2c delay to suppress any rx thumps
   set_af_gain( af_gain );                  // unmute rx
-  if( mode != DIGI ) agc_sig = 0.2;        // start with 20 over volume setting in agc system
+  set_agc_gain( agc_gain );                // agc2 was used for the mic
   #ifdef USE_OLED                          // print max mic volume during transmit
+    OLD.clrRow(3);                         // transmit ALC and drive bar
     OLD.print(( char * )"Mod ", 128 - 8*6, ROW2);
     OLD.printNumI( magpmax, RIGHT, ROW2, 4, ' ' );
     magpmax = 0;
   #endif
   if( screen_user == INFO ) info_headers();
-  if( screen_user == FFT_SCOPE ) Scope2.setmode( 1 );
+  if( screen_user == FFT_SCOPE ) IQscope.setmode( 1 );
+  if( screen_user == CW_SKIM ) Skimmer.setmode( 1 );
 }
 
 
-void S_meter( float sig){
+// sig is the agc envelope, the peak level before the agc gain.  S9 is 1/8 of full scale and an S unit is 6 db.
+int agc_db( int32_t sig ){                   // 1.5 db steps
+int db;
+
+  db = 0;
+  while( sig > 7 ) ++db, sig >>= 1;          // log 2 with 2 fraction bits, 4096 gives 40
+  return 4 * db + ( sig & 3 );
+}
+
+void S_meter( int32_t sig){
 int i;
 int s;
 int j;
 char c;
+int db;                                      // 1.5 db steps
+
+  db = agc_db( sig );
 
   c = ( attn2 ) ? 'A' : 'S';                 // a visual of the attenuator setting
-  s = sig * 100;
+  s = 9 + ( db - 40 ) / 4;                   // 4096 is S9
   s = constrain(s,1,9);
   #ifdef USE_OLED
    OLD.gotoRowCol(1,0);  OLD.putch(c); OLD.write(0);
@@ -1170,7 +1479,8 @@ char c;
      }
      else j = 0; 
   }
-  s = sig * 10; j = 0xff;
+  s = ( db - 40 ) * 3 / 20;                  // 10 db bars over S9
+  j = 0xff;
   if( s > 4 ) s = 4;
   for( i = 1; i <= 4; ++i ){
      if( i > s ) j = 0;
@@ -1184,11 +1494,24 @@ char c;
 }
 
 
-void loop() {
-static uint32_t tm;
-static int done2, done3, done4;
-int t;  
+// 1ms routines.  Run by the scheduler once for every millisecond, late ones are caught up rather than dropped.
+void tick_task(){
+
+   if( step_timer ) --step_timer;       // 1.5 seconds to dtap freq step up to 500k 
 
+   int t2 = button_state(0);
+   if( t2 > DONE ) button_process(t2);
+
+   if( mode == CW && key_mode != STRAIGHT ) keyer();
+   // else if( tx_source != USBc ) ptt();   // USB as tx source always key's via CAT control.
+   else ptt();                              // usb audio can use ptt ( dit ) to transmit or use CAT.
+
+   if( transmitting ) tx_status(0);
+     // eer_test2();      // !!! test freq sweep
+}
+
+void encoder_task(){
+int t;
 
    t = encoder();
    if( t ){
@@ -1199,115 +1522,205 @@ int t;
       }
       if( encoder_user == MULTI_FUN ) multi_adjust(t);    // generic knob routine, tap for other functions
    }
+}
+
+void scope_task(){
 
-   if( rms1.available() ){                              // agc
-        sig_rms = rms1.read();
-        agc_process( sig_rms);
-        report_info();
-   }
-
-   t = millis() - tm;                         // 1ms routines, loop for any missing counts
-   if( t > 10 )  t = 1;                       // first time
-   if( t > 0 ){
-      tm = millis();
-      while( t-- ){
-         if( step_timer ) --step_timer;       // 1.5 seconds to dtap freq step up to 500k 
-         
-         int t2 = button_state(0);
-         if( t2 > DONE ) button_process(t2);
-         
-         if( mode == CW && key_mode != STRAIGHT ) keyer();
-         // else if( tx_source != USBc ) ptt();   // USB as tx source always key's via CAT control.
-         else ptt();                              // usb audio can use ptt ( dit ) to transmit or use CAT.
-         
+   if( screen_user == FFT_SCOPE ) scope_update();
+}
+
+void skim_task(){
+
+   if( screen_user == CW_SKIM ) skim_process();
+}
+
+// Cooperative scheduler for loop().  The table is in priority order.  Each loop() pass runs the first task that is due
+// and returns, so the 1ms tick never waits behind more than one other task, however busy the display is.  A task is
+// late when it starts more than its deadline after it was due.  When nothing is due the cpu sleeps until the next
+// interrupt, the systick wakes it every ms.  #T reports runs, late starts and the longest run of each task.
+// The encoder is not in the table, it is polled on every pass so a fast spin isn't limited to one reading per ms.
+// No sleep while EER is on, WFI stops the DWT cycle counter that i2be_start() times the gap to the next tick with.
+#define TASK_EXACT   1                 // catch up every missed period, else the next run is a period from now
+#define TASK_RESYNC  100               // ms behind when an exact task gives up on catching up, counted as late
+
+struct TASK {
+   const char *name;
+   void (*fun)();
+   uint16_t period;                    // ms
+   uint16_t deadline;                  // ms
+   uint8_t flags;
+   uint32_t due;                       // millis() when next due
+   uint32_t runs, late;
+   uint32_t cycles_max;                // longest run
+};
+
+struct TASK tasks[] = {
+   { "tick",    tick_task,     1,  0, TASK_EXACT },    // keyer, ptt, buttons
+   { "cat",     radio_control, 1,  5, 0 },
+   { "cwread",  cw_block_read, 1,  3, 0 },             // cw decoder, one goertzel per audio block
+   { "info",    report_info,   1,  3, 0 },
+   { "meter",   agc_process,  50, 50, 0 },             // S meter from the agc envelope
+   { "notch",   notch_display,50,100, 0 },
+   { "sam",     sam_display,  50,100, 0 },
+   { "skim",    skim_task,     1, 20, 0 },
+   { "scope",   scope_task,    1, 20, 0 },
+   { "display", display_flush, 1, 20, 0 }
+};
+#define NUM_TASKS ( sizeof( tasks ) / sizeof( struct TASK ))
+
+uint32_t task_idle;                    // passes with nothing due
+uint32_t loop_last;                    // loop_profile() cycle count at the start of the last pass
+
+void task_start(){
+unsigned int i;
+
+   for( i = 0; i < NUM_TASKS; ++i ) tasks[i].due = millis();
+}
+
+// run the first due task, returns 0 when nothing was due
+int task_run(){
+struct TASK *k;
+uint32_t now, t;
+int32_t behind;
+unsigned int i;
+
+   now = millis();
+   for( i = 0; i < NUM_TASKS; ++i ){
+      k = &tasks[i];
+      behind = now - k->due;
+      if( behind < 0 ) continue;
+      if( behind > k->deadline ) ++k->late;
+      if( k->flags & TASK_EXACT ){
+         k->due += k->period;
+         if( behind > TASK_RESYNC ) k->late += behind, k->due = now + k->period;
       }
-      if( transmitting ) tx_status(0);
-        // eer_test2();      // !!! test freq sweep
-   }
-
-   //if( Serial.availableForWrite() > 20 ) radio_control();      // CAT.  Avoid any serial blocking. fails on Teensy, works on UNO.
-   radio_control();                                                     // CAT
-   if( mode == CW && CWdet.available() ) code_read( CWdet.read() );     // cw decoder using goertzel algorithm object
-   if( screen_user == FFT_SCOPE ){
-      if( Scope_det2.available() ) scope_plot( Scope_det2.read(), 15 ), done2 = 1;
-      if( Scope_det3.available() ) scope_plot( Scope_det3.read(), 30 ), done3 = 1;
-      if( Scope_det4.available() ) scope_plot( Scope_det4.read(), 45 ), done4 = 1;
-      if( Scope_det1.available() && done2 && done3 && done4 ){
-         scope_plot( Scope_det1.read(), 0);
-         done2 = done3 = done4 = 0;
+      else k->due = now + k->period;
+      t = ARM_DWT_CYCCNT;
+      k->fun();
+      t = ARM_DWT_CYCCNT - t;
+      if( t > k->cycles_max ) k->cycles_max = t;
+      ++k->runs;
+      return 1;
+   }
+   return 0;
+}
+
+void loop() {
+
+   loop_profile();
+   encoder_task();
+   if( task_run() == 0 ){
+      ++task_idle;
+      if( eer_on == 0 ){
+         __asm__ volatile( "wfi" );
+         loop_last = ARM_DWT_CYCCNT;    // the sleep isn't loop time
       }
    }
-   
 }
 
-void scope_plot( float val, int off ){
-static int mode = 1;
-static int pos = 1;
-int modep, posp;
-// int nextp;
-uint32_t  dat, dat2;
-uint8_t   low,mid,high;
-int col;
+// send one dirty range of each display per run of the display task.  While transmitting the OLED shares the I2C bus with the EER
+// interrupt and goes out in the gaps between PLLB frames.  The LCD is on its own pins.
+void display_flush(){
+
+   #ifdef USE_OLED
+     if( transmitting == 0 ) OLD.flush();
+     else if( i2be_room() >= 2 ) OLD.flush( I2BE_DATA );   // address and data frames for the best effort lane
+   #endif
+   #ifdef USE_LCD
+     LCD.flush();
+   #endif
+}
+
+void display_flush_all(){
+
+   #ifdef USE_OLED
+     OLD.flush_all();
+   #endif
+   #ifdef USE_LCD
+     LCD.flush_all();
+   #endif
+}
+
+#ifdef USE_OLED
+void oled_out( int row, int col, uint8_t *dat, int n ){
+uint8_t cmd[6];
+int i;
+
+   cmd[0] = SSD1306_SET_COLUMN_ADDR;  cmd[1] = col;  cmd[2] = 127;     // data auto increments to the end of the page
+   cmd[3] = SSD1306_SET_PAGE_ADDR;    cmd[4] = row;  cmd[5] = 7;
+   if( transmitting ){
+      i2be_post( OLED_ADDR, 0, cmd, 6 );
+      i2be_post( OLED_ADDR, 0x40, dat, n );
+      return;
+   }
+   i2start( OLED_ADDR );
+   i2send( 0 );                              // commands follow
+   for( i = 0; i < 6; ++i ) i2send( cmd[i] );
+   i2stop();
+   i2start( OLED_ADDR );
+   i2send( 0x40 );                           // data follows
+   while( n-- ) i2send( *dat++ );
+   i2stop();
+}
+#endif
+
+#ifdef USE_LCD
+void lcd_out( int row, int col, uint8_t *dat, int n ){
+
+   LCDhw.gotoRowCol( row, col );
+   while( n-- ) LCDhw.write( *dat++ );
+}
+#endif
+
+// copy out a finished FFT and plot a few columns per pass so the display writes do not hold up the keyer
+void scope_update(){
+static uint16_t bins[256];
+static int col = 128;                        // next column to plot, 128 when waiting for a new FFT
+int i;
 
    if( encoder_user != FREQ ) return;
    if( transmitting ) return;
-   
-   //Serial.print( val );
-   modep = mode;
-   posp = pos + off;
-   if( off == 0 ){
-      if( ++pos > 15 ){
-        pos = 1;
-        mode = ( mode == 1 )? 2 : 1;
-        Scope2.setmode( mode );
-      }
+
+   if( col >= 128 ){
+      if( IQscope.available() == 0 ) return;
+      AudioNoInterrupts();                   // FFT may finish during the copy
+      for( i = 0; i < 256; ++i ) bins[i] = IQscope.read(i);
+      AudioInterrupts();
+      col = 0;
    }
-   if( off == 0 ) Scope_det1.frequency( 300 * pos, 3 * pos );         // start next freq bin detect. 3* works good but slow
-   if( off == 15 ) Scope_det2.frequency( 300 * (pos + off + 1), 3 * (off + pos + 1) );
-   if( off == 30 ) Scope_det3.frequency( 300 * (pos + off + 1), 3 * (off + pos + 1) );
-   if( off == 45 ) Scope_det4.frequency( 300 * (pos + off + 1), 3 * (off + pos + 1) );
-   
-   //val = val * val;
-   val = val * val * val;
-   dat = (uint32_t)(16777215.0 * val);       // expand to 3 bytes
+   for( i = 0; i < 8 && col < 128; ++i, ++col ) scope_plot( bins, col );
+}
+
+// vfo in the center column, two bins per column, about 345 hz per column
+void scope_plot( uint16_t *bins, int col ){
+uint32_t  dat, dat2;
+uint8_t   low,mid,high;
+int h;
+
+   h = ( 2 * ( col - 64 )) & 255;            // frequencies below the vfo are in the top half of the bins
+   dat = max( bins[h], bins[h+1] );
    dat >>= 1;                                // shift out noise floor
-   //dat &= 0x7fff;
-   //Serial.println( dat );
-   //if( dat == 0 ) return;
-   dat2 = 0x800000;
-   //dat2 = 0;
-   while( dat ){                             // sort of log 2
-     dat2 >>= 1;
-     dat2 |= 0x800000;
-     dat >>= 1;
-   }
+   h = 0;
+   while( dat ) ++h, dat >>= 1;              // sort of log 2
+   h = 1 + ( 23 * h ) / 15;                  // 1 to 24 pixels
+   dat2 = ( 0xffffff << ( 24 - h )) & 0xffffff;
 
-   
    low = dat2 >> 16;
    mid = dat2 >> 8;
    high = dat2;       // & 0xff;
 
-  // Serial.print( high );  Serial.write(' ');
-  // Serial.println( low );
-
-   
    #ifdef USE_LCD
-     if( posp <= 41 ){
-        if( modep == 1 ) col = 40 + posp;
-        else col = 41 - posp;
-
-        LCD.gotoRowCol( 5,col );
+     h = col - 64 + 41;                      // 84 columns, center part of the FFT
+     if( h >= 0 && h < 84 ){
+        LCD.gotoRowCol( 5,h );
         LCD.write( low );
-        LCD.gotoRowCol( 4,col );
+        LCD.gotoRowCol( 4,h );
         LCD.write( mid );
-        LCD.gotoRowCol( 3,col );
+        LCD.gotoRowCol( 3,h );
         LCD.write( high );
      }
    #endif
    #ifdef USE_OLED
-        if( modep == 1 ) col = 64 + posp;
-        else col = 65 - posp;
-
         OLD.gotoRowCol( 7,col );
         OLD.write( low );
         OLD.gotoRowCol( 6,col );
@@ -1318,13 +1731,13 @@ int col;
   
 }
 
-// can show info on LCD but not on OLED while transmitting
+// live transmit status, cpu and I2C overruns on the LCD, ALC and drive on both
 void tx_status( int clr ){
 static int count;
 int num;
 int i;
 
-#ifdef USE_OLED                // can only show something at start of tx or at the end
+#ifdef USE_OLED                // OLED writes are sent between the EER frames by the I2C arbiter
    if( clr ){
        OLD.gotoRowCol(1,0);    // make it short as soon the I2C will be very busy
        OLD.putch('T');
@@ -1345,7 +1758,7 @@ int i;
    num = AudioProcessorUsage();
    num = constrain(num,0,99);
    LCD.printNumI(num,5*6,ROW0,2,' ');
-   num = constrain(overs,0,99);
+   num = constrain(si5351.q_late + si5351.q_drops,0,99);
    LCD.printNumI(num,RIGHT,ROW0,2,' ');
    num = map( magp,0,1024,0,14 );
    LCD.gotoRowCol( 5, 0 );
@@ -1354,6 +1767,18 @@ int i;
    LCD.printNumF(alc,1,RIGHT,ROW3);
 #endif
 
+#ifdef USE_OLED
+   if( count == 0 ){
+      num = map( magp,0,1024,0,80 );
+      num = constrain( num,0,80 );
+      OLD.print(( char * )"ALC", 0, ROW3 );
+      OLD.printNumF( alc,1,4*6,ROW3 );
+      OLD.gotoRowCol( 3, 128-80 );
+      OLD.write( 0x3c, num );                 // drive bar
+      OLD.write( 0, 80 - num );
+   }
+#endif
+
    if( magp > magpmax ) magpmax = magp;     // print max mag on OLED after transmit.
    
 }
@@ -1415,10 +1840,10 @@ float amp;
 
   // return;   
   // Serial.print(sec);   Serial.write(' ');
-  // Serial.print(eer_adj); Serial.write(' ');
+  // Serial.print(MagPhase.underruns); Serial.write(' ');
   // Serial.print(temp_count); Serial.write(' ');
   // Serial.print( eer_time,5 ); Serial.write(' ');
-  // Serial.println( overs );
+  // Serial.println( si5351.q_late );
    if( tx_source != SIDETONE ){
       tx_source = SIDETONE;
       set_tx_source();
@@ -1433,7 +1858,6 @@ float amp;
    }
    LCD.printNumF(eer_time,5,0,ROW3);
 
-   eer_adj = 0;
    if( sec == 10 ) sec = 0;
    if( sec == 1 ) tx();             // !!! n second transmit test out of N seconds
    if( sec == 5 ) rx();
@@ -1517,7 +1941,9 @@ void button_process( int t ){
 
 // once just volume, now general use knob function
 void multi_adjust( int val ){
-const char *msg[] = {"Volume  ","RF gain ","CW det  ","SideTon ", "Key Spd ", "Tone    ", "TXdrive ", "TXphase "}; 
+const char *msg[] = {"Volume  ","RF gain ","CW det  ","SideTon ", "Key Spd ", "Tone    ", "TXdrive ", "TXphase ",
+                     "TX rate ", "NR      ", "NB      ",
+                     "Notch   ", "SAM sb  "}; 
 float pval; 
 
    if( val == 0  ){     // first entry, clear status line
@@ -1573,8 +1999,8 @@ float pval;
         pval = wpm;
       break;
       case TONE_U:
-        tone_ += (float)val * 0.02;
-        tone_ = constrain(tone_,-0.4,0.4);
+        tone_ += (float)val * WEAVER_TONE_Q;
+        tone_ = constrain(tone_,-WEAVER_TONE * WEAVER_TONE_Q,WEAVER_TONE * WEAVER_TONE_Q);
         set_bandwidth();                // tone is changed by changing the Q of the bandwidth filter
         pval = tone_;
       break;
@@ -1589,6 +2015,35 @@ float pval;
         phase_delay = constrain(phase_delay,-7,7);
         pval = phase_delay;
       break;
+      case TX_RATE_U:                         // takes effect on the next transmit
+        tx_rate += val;
+        tx_rate = constrain(tx_rate,4,6);
+        pval = tx_rate;
+      break;
+      case NR_U:
+        nr_strength += val;
+        nr_strength = constrain(nr_strength,0,10);
+        NR.strength( nr_strength );
+        pval = nr_strength;
+      break;
+      case NB_U:
+        nb_level += val;
+        nb_level = constrain(nb_level,0,10);
+        NB.level( nb_level );
+        pval = nb_level;
+      break;
+      case NOTCH_U:
+        notch_rate += val;
+        notch_rate = constrain(notch_rate,0,10);
+        set_notch();
+        pval = notch_rate;
+      break;
+      case SAM_U:
+        sam_sb += val;
+        sam_sb = constrain(sam_sb,0,2);
+        if( mode == AM ) Weaver.sideband( WEAVER_SAM + sam_sb );
+        pval = sam_sb;
+      break;
    }
    
    #ifdef USE_LCD
@@ -1613,13 +2068,15 @@ float drive;
 
 void qsy( uint32_t f ){
 static int cw_offset = 700;
+int tag;
 
     // with weaver rx, freq is the display frequency.  vfo and bfo move about with bandwidth changes.
     if( transmitting ) return;                            // can't use I2C for other purposes during transmit
     freq = f;
+    tag = i2_tag_push( I2F_QSY );
 
     switch( mode ){
-       case AM:  f += 2500;  break;            // tune AM off frequency to pass the carrier tone.      
+       case AM:  f += WEAVER_SAM_HZ;  break;   // carrier off the adc dc block, the SAM pll finds it
        case CW:  f += cw_offset;               // no break
        case LDSB:
        case LSB: f -= bfo;   break;
@@ -1633,7 +2090,7 @@ static int cw_offset = 700;
          si5351.freq_calc_fast(-cw_offset + bfo);         // else change it
          si5351.SendPLLBRegisterBulk();                   // TX at freq specified.       
     }
-    
+    i2_tag = tag;
 }
 
 void status_display(){
@@ -1679,7 +2136,10 @@ char buf[20];
 
 
 void band_change( int to_band ){
+int tag;
 
+  tag = i2_tag_push( I2F_BAND );
+  si5351.shadow_clear();               // rewrite every register on a band change, resyncs the shadow with the chip
   bandstack[band].freq = freq;
   bandstack[band].mode = mode;
   bandstack[band].stp  = step_;
@@ -1693,34 +2153,82 @@ void band_change( int to_band ){
   set_tx_source();
   filter = bandstack[band].fltr;
   mode_change(bandstack[band].mode);
+  i2_tag = tag;
 //  qsy( bandstack[band].freq );  // done in mode_change
 //  status_display();            delay until after screen clear  
 }
 
+// auto notch in the voice modes only, it would take out a CW signal or the DIGI tones
+void set_notch(){
+
+   if( mode == CW || mode == DIGI ) Notch.rate( 0 );
+   else Notch.rate( notch_rate );
+}
+
+// show the frequency being notched, on the row under the status line
+void notch_display(){
+static uint32_t tm;
+static int shown;
+char buf[12];
+int f, i;
+
+   if( millis() - tm < 500 ) return;
+   tm = millis();
+   if( transmitting || encoder_user != FREQ ) return;
+   f = ( notch_rate && mode != CW && mode != DIGI && Notch.level() > 100 ) ? Notch.frequency() : 0;
+   if( f == 0 && shown == 0 ) return;
+   shown = f;
+   strcpy( buf, "      " );                 // fixed width, "N" and 4 digits right aligned then a space, same as the clear
+   if( f ){
+      buf[0] = 'N';
+      f = constrain( f, 0, 9999 );
+      for( i = 4; f; f /= 10, --i ) buf[i] = '0' + f % 10;
+   }
+   #ifdef USE_OLED
+     OLD.print( buf, RIGHT, ROW3 );
+   #endif
+   #ifdef USE_LCD
+     LCD.print( buf, RIGHT, ROW3 );
+   #endif
+}
+
+// SAM lock and how far the carrier is from where it should be, on the left of the row under the status line
+void sam_display(){
+static uint32_t tm;
+static int shown;
+char buf[12];
+
+   if( millis() - tm < 500 ) return;
+   tm = millis();
+   if( transmitting || encoder_user != FREQ ) return;
+   if( mode != AM && shown == 0 ) return;
+   if( mode == AM ){
+      buf[0] = 'S';                       // short enough to leave room for the notch on the LCD
+      if( Weaver.locked() ) itoa( Weaver.sam_offset(), buf + 1, 10 );
+      else strcpy( buf + 1, "--" );
+      strcat( buf, "     " );
+      buf[6] = 0;
+   }
+   else strcpy( buf, "      " );
+   shown = ( mode == AM );
+   #ifdef USE_OLED
+     OLD.print( buf, 0, ROW3 );
+   #endif
+   #ifdef USE_LCD
+     LCD.print( buf, 0, ROW3 );
+   #endif
+}
+
 void mode_change( int to_mode ){
 
   mode = to_mode;
   //qsy( freq );                                     // redundant with weaver rx, to get phasing correct on QSD
-  if( mode == CW || mode == LSB  || mode == LDSB ){
-     SSB.gain(1,1.0);             // add for LSB
-     SSB.gain(2,1.0);
-     SSB.gain(0,0.0);
-     SSB.gain(3,0.0);
-  }
-  else if( mode == AM ){
-     SSB.gain(1,0.0);  
-     SSB.gain(2,0.0);
-     SSB.gain(0,1.0);             // AM audio path select
-     SSB.gain(3,0.0);    
-  }
-  else{
-     SSB.gain(1,1.0);             // sub for USB
-     SSB.gain(2,-1.0);
-     SSB.gain(0,0.0);
-     SSB.gain(3,0.0);
-  }
+  if( mode == CW || mode == LSB  || mode == LDSB ) Weaver.sideband( WEAVER_LSB );     // add for LSB
+  else if( mode == AM ) Weaver.sideband( WEAVER_SAM + sam_sb );                       // synchronous AM
+  else Weaver.sideband( WEAVER_USB );                                                 // sub for USB
   //set_af_gain(af_gain);                              // listen to the correct audio path
   set_bandwidth();                                   // bandwidth is mode dependent
+  set_notch();
   //if( mode == CW ) pinMode(DAHpin, INPUT_PULLUP);    // accomdate the hardware jumper difference when in CW mode. 
   //else pinMode(DAHpin, INPUT );                      // Let 10k pullup work alone. !!! not wired it seems
   delay(1);
@@ -1883,33 +2391,23 @@ char priv[2];
 }
 
 
-#define AGC_FLOOR  0.05             //  was 0.035,  0.07 in my QCX_IF program
-#define AGC_SLOPE 6
-#define AGC_HANG   500              //  hang == ms time
-void agc_process( float reading ){
-//static float sig = AGC_FLOOR;
-static int hang;
-float g;
-int ch;                            // flag change needed
-
-    ch = 0;
-    
-    if( reading > agc_sig && reading > AGC_FLOOR ){       // attack
-       agc_sig += 0.001,  hang = 0, ch = 1;
-    }
-    else if( agc_sig > AGC_FLOOR && hang++ > AGC_HANG/3 ){  // decay
-       agc_sig -= 0.0001, ch = 1;
-    }
-
-    if( ch ){                                         // change needed
-      if( encoder_user == FREQ && transmitting == 0 ) S_meter( agc_sig );
-      g = agc_sig - AGC_FLOOR;
-      g *= AGC_SLOPE;
-      g = agc_gain - g;
-      if( g <= 0 ) g = 0.1;
-      set_agc_gain(g);
-    }                                               
+#define AGC_ATTACK   2              // ms, the look ahead block catches the fast rise
+#define AGC_HANG   500              // ms
+#define AGC_DECAY  300              // ms
+#define AGC_LEVEL 4000              // output peak to hold, about -18 db of full scale
 
+// The AGC itself is now the agc audio object after the BandWidth filter.  Just update the S meter here.
+void agc_process(){
+static uint32_t tm;
+static int32_t last;
+int32_t env;
+
+    if( millis() - tm < 50 ) return;
+    tm = millis();
+    env = agc.envelope();
+    if( env == last ) return;
+    last = env;
+    if( encoder_user == FREQ && transmitting == 0 ) S_meter( env );
 }
 
 
@@ -1920,8 +2418,8 @@ static int last;       /* save the previous reading */
 int new_;              /* this reading */
 int b;
 
-   // if( transmitting && encoder_user != MULTI_FUN ) return 0;         // allow adjusting tx drive while transmitting
-   if( transmitting ) return 0;                                         // maybe that is not a good idea when using the OLED, program hangs
+   // tx drive can be adjusted while transmitting, the OLED writes go through the I2C arbiter
+   if( transmitting && ( encoder_user != MULTI_FUN || multi_user != TX_DRIVE_U )) return 0;
    
    new_ = (digitalReadFast(EN_B) << 1 ) | digitalReadFast(EN_A);
    if( new_ == last ) return 0;       /* no change */
@@ -1966,11 +2464,13 @@ int sw;
      return st;        
 }
 
- // check if need a band change before changing frequency from CAT control
-void cat_qsy( int32_t f ){
+ // check if need a band change before changing frequency from CAT control.  Returns 0 and does nothing when f is
+ // off the ends of the band table, below 3.5 MHz the 80 meter divider is out of range for the si5351 code.
+int cat_qsy( int32_t f ){
 const int32_t band_breaks[9] = { 4500000,6500000,8500000,12500000,15500000,19500000,23000000,26000000,33000000 };
 int  i;
 
+   if( f < 3500000 || f >= band_breaks[8] ) return 0;
    for( i = 0; i < 9; ++i ){
       if( f < band_breaks[i] ) break;
    }
@@ -1981,6 +2481,7 @@ int  i;
    }
    qsy( f );
    freq_display();
+   return 1;
 }
 
 
@@ -2001,6 +2502,29 @@ int  i;
 char command[CMDLEN];
 uint8_t vfo = 'A';
 
+void cat_put( char c ){
+
+   if( (uint16_t)( cat_in - cat_out ) >= CAT_OUT ){
+      ++cat_drops;
+      return;
+   }
+   cat_buf[cat_in++ & ( CAT_OUT - 1 )] = c;
+}
+
+void cat_flush(){
+int n, room;
+
+   n = (uint16_t)( cat_in - cat_out );
+   if( n == 0 ) return;
+   room = Serial.availableForWrite();                     // space left in the USB packet being built
+   if( n > room ) n = room;
+   if( n > CAT_OUT - ( cat_out & ( CAT_OUT - 1 )) ) n = CAT_OUT - ( cat_out & ( CAT_OUT - 1 ));    // to the ring end
+   if( n <= 0 ) return;
+   Serial.write( &cat_buf[cat_out & ( CAT_OUT - 1 )], n );
+   cat_out += n;
+   if( cat_in == cat_out ) Serial.send_now();             // reply complete, don't wait for the packet timeout
+}
+
 void radio_control() {
 static int expect_len = 0;
 static int len = 0;
@@ -2009,6 +2533,7 @@ static char cmd;
 char c;
 int done;
 
+    cat_flush();
     if (Serial.available() == 0) return;
     
     done = 0;
@@ -2019,6 +2544,13 @@ int done;
        if( len == 1 ) cmd = c;       /* first char */
        /* sync ok ? */
        if( cmd == '?' || cmd == '*' || cmd == '#' );  /* ok */
+       else if( cmd >= 'A' && cmd <= 'Z' ){           /* Kenwood, ends with ; */
+          if( c == ';' ){
+             done = 1;
+             break;
+          }
+          continue;
+       }
        else{
           len= 0;
           return;
@@ -2031,6 +2563,13 @@ int done;
     }
     
     if( done == 0 ) return;  /* command not complete yet */
+
+    if( cmd >= 'A' && cmd <= 'Z' ){
+       kw_cmd( len - 1 );
+       len = expect_len = 0;
+       cat_flush();
+       return;
+    }
         
     if( cmd == '?' ){
       get_cmd();
@@ -2048,6 +2587,7 @@ int done;
    len = expect_len= 0;
    stage('G');       /* they are all good commands */
    stage('\r');
+   cat_flush();
 
 }
 
@@ -2218,12 +2758,154 @@ char cmd2;
    switch(cmd2){
      case '0':  rx();  break;    // enter rx mode
      case '1':  tx();  break;    // TX
+     case 'P':  profile_report();  break;    // cpu profile
+     case 'R':  profile_reset();   break;    // clear the profile worst case values
+     case 'K':  skim_report();     break;    // cw skimmer text
+     case 'I':  i2_report();       break;    // I2C traffic by feature
+     case 'T':  task_report();     break;    // scheduler
    }
 
 }
 
 /********************* end Argo V CAT ******************************/
 
+/*****************************************************************************************/
+// Kenwood TS-480 CAT subset, for loggers and WSJT-X.  Two letters, any parameters, then ';'.  A read replies with the
+// same two letters, the value and ';'.  Sets are silent, unknown commands and bad values get "?;" like the radio.
+// DIGI reports as USB, FM or FSK select it.
+
+void kw_digits( uint32_t val, int n ){     // n digits with leading zeros
+char b[12];
+int i;
+
+   for( i = n - 1; i >= 0; --i ) b[i] = '0' + val % 10, val /= 10;
+   for( i = 0; i < n; ++i ) stage( b[i] );
+}
+
+int kw_value( const char *arg, int len, uint32_t *val ){   // 0 if not all digits, past 32 bits saturates
+uint64_t v;
+
+   v = 0;
+   while( len-- ){
+      if( *arg < '0' || *arg > '9' ) return 0;
+      v = 10 * v + ( *arg++ - '0' );
+   }
+   *val = ( v > 0xffffffff ) ? 0xffffffff : v;
+   return 1;
+}
+
+int kw_mode_code(){                         // mode as a TS-480 MD value
+const char codes[7] = { 5, 2, 1, 3, 2, 2, 1 };       // AM USB LSB CW DIGI UDSB LDSB
+
+   return codes[mode];
+}
+
+void kw_freq( const char *cmd, int len ){
+uint32_t f;
+
+   if( len == 0 ){
+      stage( cmd[0] );  stage( cmd[1] );
+      kw_digits( freq, 11 );
+      stage(';');
+   }
+   else if( len != 11 || kw_value( cmd + 2, len, &f ) == 0 || cat_qsy( f ) == 0 ){
+      stage('?');  stage(';');                     // not 11 digits, or off the band table
+   }
+}
+
+void kw_info( const char *cmd, int len ){
+const char *p;
+
+   stage('I');  stage('F');
+   kw_digits( freq, 11 );
+   for( p = "     +0000"; *p; ++p ) stage( *p );           // step, rit offset
+   stage( ( rit_enabled ) ? '1' : '0' );                   // rit, xit, memory bank and channel
+   for( p = "0000"; *p; ++p ) stage( *p );
+   stage( ( transmitting ) ? '1' : '0' );
+   stage( '0' + kw_mode_code() );
+   for( p = "0000000"; *p; ++p ) stage( *p );              // vfo, scan, split, tone, tone number, shift
+   stage(';');
+}
+
+void kw_mode( const char *cmd, int len ){
+const signed char modes[10] = { -1, LSB, USB, CW, DIGI, AM, DIGI, CW, -1, DIGI };
+int i;
+
+   if( len == 0 ){
+      stage('M');  stage('D');
+      stage( '0' + kw_mode_code() );
+      stage(';');
+      return;
+   }
+   i = cmd[2] - '0';
+   if( len != 1 || i < 0 || i > 9 || modes[i] < 0 ) return;
+   if( i == kw_mode_code() ) return;                       // already there, DIGI and the DSB modes stay as they are
+   mode_change( modes[i] );
+   status_display();
+}
+
+void kw_tx( const char *cmd, int len ){
+
+   if( transmitting == 0 ) tx();
+}
+
+void kw_rx( const char *cmd, int len ){
+
+   if( transmitting ) rx();
+}
+
+void kw_smeter( const char *cmd, int len ){                // 0 to 30, S9 is 16
+
+   stage('S');  stage('M');  stage('0');
+   kw_digits( constrain( ( agc_db( agc.envelope() ) - 8 ) / 2, 0, 30 ), 4 );
+   stage(';');
+}
+
+struct KW_CMD {
+   char name[3];
+   void (*fun)( const char *cmd, int len );        // len is the parameter length, 0 for a read
+   const char *val;                                // fixed read reply when there is no function, sets are ignored
+};
+
+const struct KW_CMD kw_cmds[] = {
+   { "FA", kw_freq,   0 },
+   { "FB", kw_freq,   0 },
+   { "IF", kw_info,   0 },
+   { "MD", kw_mode,   0 },
+   { "TX", kw_tx,     0 },
+   { "RX", kw_rx,     0 },
+   { "SM", kw_smeter, 0 },
+   { "ID", 0, "020" },                             // TS-480
+   { "AI", 0, "0" },                               // no auto information
+   { "PS", 0, "1" },
+   { "FR", 0, "0" },
+   { "FT", 0, "0" }
+};
+
+#define NUM_KW  ( sizeof(kw_cmds) / sizeof(kw_cmds[0]) )
+
+// len is the command length without the ';'
+void kw_cmd( int len ){
+const char *p;
+unsigned int i;
+
+   if( len >= 2 ){
+      for( i = 0; i < NUM_KW; ++i ){
+         if( command[0] != kw_cmds[i].name[0] || command[1] != kw_cmds[i].name[1] ) continue;
+         if( kw_cmds[i].fun ) kw_cmds[i].fun( command, len - 2 );
+         else if( len == 2 ){
+            stage( command[0] );  stage( command[1] );
+            for( p = kw_cmds[i].val; *p; ++p ) stage( *p );
+            stage(';');
+         }
+         return;
+      }
+   }
+   stage('?');  stage(';');
+}
+
+/********************* end Kenwood CAT ******************************/
+
 int read_paddles(){                    // keyer and/or PTT function
 int pdl;
 int tch_dit;
@@ -2344,119 +3026,243 @@ int pdl;
 }
 
 
-// ***************   group of functions for a read behind morse decoder    ******************
-//   attempts to correct for incorrect code spacing, the most common fault.
-int cread_buf[16];
-int cread_indx;
-int dah_table[8] = { 20,20,20,20,20,20,20,20 };
-int dah_in;
-
-// try using both the tone detect and rms level added together, not sure they work well alone.  NOT done for this test
-
-int cw_detect(float av ){
-int det;                        // cw mark space detect
-static int count;               // mark,space counts
-static float rav;               // running average of signals
-static int last_good;           // tone returns zero?
-int stored;
+// Block rate decoder for the CW decode screen.  CWdet gives the tone envelope every 2.9ms audio block.  A mark starts
+// half way between the noise floor and the mark peak and must hold for 2 blocks.  Mark lengths go in a histogram that
+// decays, and the dit dah split is the threshold that best separates its two clusters ( Otsu's method ).  Letter and
+// word spaces are 2 and 5 dits, so a letter prints as soon as its space is long enough.
+#define CWB_HIST 128                // mark lengths in blocks, 128 is 370ms, a dah at 10 wpm
+
+struct CW_BLOCK {
+   int32_t noise;                   // levels are 4 bits fractional
+   int32_t peak;
+   int state;                       // 1 when marking
+   int len;                         // blocks in this state
+   int pend;                        // blocks the detector has disagreed with state
+   uint8_t code;                    // elements, dah is 1
+   int nel;                         // elements in code
+   int spaced;                      // 1 letter space printed, 2 word space printed
+   uint16_t hist[CWB_HIST];
+   int marks;                       // since the histogram decayed
+   int split;                       // blocks, dit below and dah at or above
+   int dit;                         // blocks
+};
+struct CW_BLOCK cwb;
 
-//static int mod;
-//if( ++mod > 100 ){
-// LCD.printNumF(av,4,LEFT,ROW3);
-// LCD.printNumF(rav,4,RIGHT,ROW3);    // was once printing sig_rms for the am style decoder !!!
-// mod = 0;
-//}
- 
-   if( av < 0.0001 ) av = last_good;      // sometimes tone object returns zero
-   else last_good = av;
-   // av += sig_rms;                      // add in rms amplitude to the tone detector
+uint8_t morse_rev[256];             // morse table format to character, direct index
 
-   det = ( av > cw_det_val * rav ) ? 1 : 0;
-   if( det ) av = av/2.0;                 // if we think have signal, don't add in as much to the noise signal level
+void morse_rev_init(){
+int i;
 
-   rav = 31.0*rav + av;     // try a longer time constant here?  Maybe shorter for faster code and
-   rav /= 32.0;             // longer for slower code would work best to avoid noise in between characters.
-                            // trade off for fast fading signals being lost with longer constant.
-   
+   memset( morse_rev, 0, sizeof( morse_rev ));
+   for( i = 0; i < 47; ++i ) morse_rev[(uint8_t)morse[i]] = i + ',';
+}
+
+void cw_block_init(){
+int i;
+
+   memset( &cwb, 0, sizeof( cwb ));
+   cwb.dit = 21;                                   // 20 wpm is 60ms
+   cwb.split = 2 * cwb.dit;
+   for( i = 0; i < 3; ++i ) cwb.hist[cwb.dit] += 16, cwb.hist[3*cwb.dit] += 16;
+}
+
+// find the dit dah split from the mark histogram
+// Otsu split of the mark histogram into dits and dahs, in integers with running sums.  The histogram decays to about 2k
+// in total, so the sums fit 32 bits and the means are Q8.  Two hardware divides per bin, the variance compare is 64 bit.
+void cw_block_speed(){
+int t, best_t;
+int32_t w, sum, wb, sumb, mb, mf, d, best_mb, best_mf;
+uint64_t v, best;
+
+   w = sum = 0;
+   for( t = 1; t < CWB_HIST; ++t ) w += cwb.hist[t], sum += t * cwb.hist[t];
+   wb = sumb = best_mb = best_mf = 0;
+   best = 0;
+   best_t = 0;
+   for( t = 1; t < CWB_HIST - 1; ++t ){
+      wb += cwb.hist[t];
+      sumb += t * cwb.hist[t];
+      if( wb == 0 ) continue;
+      if( w - wb == 0 ) break;
+      mb = ( sumb << 8 ) / wb;
+      mf = (( sum - sumb ) << 8 ) / ( w - wb );
+      d = mf - mb;
+      v = (uint64_t)( wb * ( w - wb )) * (uint32_t)( d * d );
+      if( v > best ) best = v, best_t = t, best_mb = mb, best_mf = mf;
+   }
+   if( best_t == 0 || best_mf < 2 * best_mb ) return;        // only one cluster, all dits or all dahs, keep the last
+   cwb.split = best_t + 1;
+   cwb.dit = ( best_mb + 128 ) >> 8;
+   if( cwb.dit < 2 ) cwb.dit = 2;
+}
+
+void cw_block_mark_end( int len ){
+int i;
+
+   if( len >= CWB_HIST ) len = CWB_HIST - 1;
+   cwb.hist[len] += 16;
+   if( ++cwb.marks >= 32 ){                        // forget old speeds
+      cwb.marks = 0;
+      for( i = 0; i < CWB_HIST; ++i ) cwb.hist[i] -= cwb.hist[i] >> 2;
+   }
+   cw_block_speed();
+
+   if( cwb.nel < 7 ) cwb.code = ( cwb.code << 1 ) | ( len >= cwb.split );
+   ++cwb.nel;
+   cwb.spaced = 0;
+}
+
+void cw_block_letter(){
+uint8_t m;
+int i;
+
+   if( cwb.nel == 0 ) return;
+   m = ( cwb.code << 1 ) | 1;                      // stop bit then left align, morse table format
+   for( i = cwb.nel; i < 7; ++i ) m <<= 1;
+   if( cwb.nel <= 7 && morse_rev[m] ) decode_print( morse_rev[m] );
+   cwb.code = 0;
+   cwb.nel = 0;
+}
+
+void cw_block( uint16_t env ){
+int32_t m;
+int det;
+
+   m = env << 4;
+   if( m < cwb.noise ) cwb.noise -= ( cwb.noise - m ) >> 2;
+   else cwb.noise += (( m - cwb.noise ) >> 9 ) + 1;
+   if( m > cwb.peak ) cwb.peak = m;
+   else cwb.peak -= cwb.peak >> 7;                  // decays in about a second
+
+   if( cwb.state ) det = ( 2 * m > cwb.noise + cwb.peak / 2 );          // hysteresis
+   else det = ( 2 * m > cwb.noise + cwb.peak );
+   if( cwb.peak < 2 * cw_det_val * cwb.noise ) det = 0;                  // signal to noise gate
+
+   ++cwb.len;
+   if( det != cwb.state ){
+      if( ++cwb.pend < 2 ) return;                  // one block glitch
+      if( cwb.state ) cw_block_mark_end( cwb.len - cwb.pend );
+      cwb.state = det;
+      cwb.len = cwb.pend;
+      cwb.pend = 0;
+      return;
+   }
+   cwb.pend = 0;
+
+   if( cwb.state ) return;
+   if( cwb.spaced == 0 && cwb.len >= 2 * cwb.dit ){
+      cw_block_letter();
+      cwb.spaced = 1;
+   }
+   if( cwb.spaced == 1 && cwb.len >= 5 * cwb.dit ){
+      decode_print(' ');
+      cwb.spaced = 2;
+   }
+}
 
-   det = cw_denoise( det );
-       
-   // debug arduino graph values to see signals
-  // Serial.print( 10*av ); Serial.write(' '); Serial.print(10*rav); Serial.write(' ');
-  // Serial.write(' '); Serial.println(det);
+// run the decoder on every block the CWdet object has queued
+void cw_block_read(){
+uint16_t e;
+
+   while( CWdet.available() ){
+      e = CWdet.read();
+      if( transmitting || mode != CW || encoder_user != FREQ || screen_user != CW_DECODE ) continue;
+      cw_block( e );
+   }
+}
+
+// ***************   group of functions for a read behind morse decoder    ******************
+//   attempts to correct for incorrect code spacing, the most common fault.
+//   All the state is in a CW_READ so each skimmer channel has its own copy.
+struct CW_READ {
+   int cread_buf[16];
+   int cread_indx;
+   int dah_table[8];
+   int dah_in;
+   int dah_min;                 // shortest mark stored as a dah, 12 for 10ms per sample
+   int count;                   // mark ( negative ) and space counts
+   int den;                     // denoise bits
+   int wt;                      // heavy weighting will mess up the algorithm, so this compensation factor
+   int singles;
+   int farns, ch_count;
+   int eees;
+};
+
+// count marks and spaces, store the count when the signal changes.  Returns true when a count was stored.
+int cw_mark( struct CW_READ *r, int det ){
+int stored;
 
    stored = 0;
    if( det ){                // marking
-      if( count > 0 ){
-         if( count < 99 ) storecount(count), stored = 1;
-         count = 0;
+      if( r->count > 0 ){
+         if( r->count < 99 ) storecount( r, r->count ), stored = 1;
+         r->count = 0;
       }
-      --count;
+      --r->count;
    }
    else{                     // spacing
-      if( count < 0 ){
-        storecount(count), stored = 1;
-        count = 0; 
+      if( r->count < 0 ){
+        storecount( r, r->count ), stored = 1;
+        r->count = 0; 
       }
-      ++count;
-      if( count == 99 ) storecount(count), stored = 1;  // one second no signal
+      ++r->count;
+      if( r->count == 99 ) storecount( r, r->count ), stored = 1;  // one second no signal
    }
    
    return stored;
 }
 
 // slide some bits around to remove 1 reversal of mark space
-int cw_denoise( int m ){
-static int val;
+int cw_denoise( struct CW_READ *r, int m ){
 
    if( m ){
-      val <<= 1;
-      val |= 1;
+      r->den <<= 1;
+      r->den |= 1;
    }
-   else val >>= 1;
+   else r->den >>= 1;
 
-   val &= 7;
-   if( m ) return val & 4;      // need 3 marks in a row to return true
-   else return val & 2;         // 1 extra mark returned when spacing
+   r->den &= 7;
+   if( m ) return r->den & 4;   // need 3 marks in a row to return true
+   else return r->den & 2;      // 1 extra mark returned when spacing
                                 // so min mark count we see is -2 if this works correctly
                                 // this shortens mark count by 1 which may be ok as
                                 // the tone detect seems to stretch the tone present time
 }
 
 // store mark space counts for cw decode
-void storecount( int count ){
+void storecount( struct CW_READ *r, int count ){
 
-     cread_buf[cread_indx++] = count;
-     cread_indx &= 15;
+     r->cread_buf[r->cread_indx++] = count;
+     r->cread_indx &= 15;
 
      if( count < 0 ){      // save dah counts
         count = -count;
-        if( count >= 12 ){      // 12 for 10ms per sample, 40 for 3ms?  work up to 25 wpm
-          dah_table[dah_in++] = count;
-          dah_in &= 7;
+        if( count >= r->dah_min ){      // 12 for 10ms per sample, 40 for 3ms?  work up to 25 wpm
+          r->dah_table[r->dah_in++] = count;
+          r->dah_in &= 7;
         }
      }
 }
 
-void shuffle_down( int count ){    /* consume the stored code read counts */
+void shuffle_down( struct CW_READ *r, int count ){    /* consume the stored code read counts */
 int i;
 
-  for( i= count; i < cread_indx; ++i ){
-    cread_buf[i-count] = cread_buf[i];
+  for( i= count; i < r->cread_indx; ++i ){
+    r->cread_buf[i-count] = r->cread_buf[i];
   }
   
-  cread_indx -= count;
-  cread_indx &= 15;     // just in case out of sync  
+  r->cread_indx -= count;
+  r->cread_indx &= 15;     // just in case out of sync  
 }
 
 
-int code_read_scan(int slice){  /* find a letter space */
+int code_read_scan( struct CW_READ *r, int slice ){  /* find a letter space */
 int ls, i;
 
 /* scan for a letter space */
    ls = -1;
-   for( i= 0; i < cread_indx; ++i ){
-      if( cread_buf[i] > slice ){
+   for( i= 0; i < r->cread_indx; ++i ){
+      if( r->cread_buf[i] > slice ){
         ls = i;
         break;
       }
@@ -2465,15 +3271,15 @@ int ls, i;
 }
 
 
-unsigned char morse_lookup( int ls, int slicer){
+unsigned char morse_lookup( struct CW_READ *r, int ls, int slicer ){
 unsigned char m_ch, ch;
 int i,elcount;
 
    /* form morse in morse table format */
    m_ch= 0;  elcount= 1;  ch= 0;
    for( i = 0; i <= ls; ++i ){
-     if( cread_buf[i] > 0 ) continue;   /* skip the spaces */
-     if( cread_buf[i] < -slicer ) m_ch |= 1;
+     if( r->cread_buf[i] > 0 ) continue;   /* skip the spaces */
+     if( r->cread_buf[i] < -slicer ) m_ch |= 1;
      m_ch <<= 1;
      ++elcount;
    }
@@ -2481,69 +3287,52 @@ int i,elcount;
    /* left align */
    while( elcount++ < 8 ) m_ch <<= 1;
 
-   /* look up in table */
-   for( i = 0; i < 47; ++i ){
-      if( m_ch == morse[i] ){
-        ch = i+',';
-        break;
-      }
-   }
+   ch = morse_rev[m_ch];               /* look up in table */
 
    return ch;  
 }
 
 // routines from my TenTec Rebel code
-void code_read( float val ){  /* convert the stored mark space counts to a letter on the screen */
+// decode a letter if a letter space has been seen.  out gets the letter and a word space, returns how many.
+int code_decode( struct CW_READ *r, char *out ){
 int slicer;
-int i;
+int i, n;
 unsigned char m_ch;
 int ls,force;
-static int wt;    /* heavy weighting will mess up the algorithm, so this compensation factor */
-static int singles;
-static int farns,ch_count;
-static int eees;
-static uint32_t tm;
-
-   if( ( millis() - tm ) < 9 ) return;     // run at 10ms rate
-   tm = millis();
-   if( transmitting) return;
-   if( encoder_user != FREQ ) return;
-   if( screen_user != CW_DECODE ) return;
-   
-   if( cw_detect( val ) == 0 && cread_indx < 15 ) return;
 
-   if( cread_indx < 2 ) return;    // need at least one mark and one space in order to decode something
+   n = 0;
+   if( r->cread_indx < 2 ) return 0;    // need at least one mark and one space in order to decode something
 
    /* find slicer from dah table */
    slicer= 0;   force= 0;
    for( i = 0; i < 8; ++i ){
-     slicer += dah_table[i];
+     slicer += r->dah_table[i];
    }
    slicer >>= 4;   /* divide by 8 and take half the value */
 
-   ls = code_read_scan(slicer + wt);
+   ls = code_read_scan( r, slicer + r->wt );
    
-   if( ls == -1 && cread_indx == 15 ){   // need to force a decode
+   if( ls == -1 && r->cread_indx == 15 ){   // need to force a decode
       for(i= 1; i < 30; ++i ){
-        ls= code_read_scan(slicer + wt - i);
+        ls= code_read_scan( r, slicer + r->wt - i );
         if( ls >= 0 ) break;
       } 
-      --wt;    /* compensate for short letter spaces */
+      --r->wt;    /* compensate for short letter spaces */
       force= 1;
    }
    
-   if( ls == -1 ) return;
+   if( ls == -1 ) return 0;
    
-   m_ch = morse_lookup( ls, slicer );
+   m_ch = morse_lookup( r, ls, slicer );
    
    /* are we getting just E and T */
    if( m_ch == 'E' || m_ch == 'T' ){   /* less weight compensation needed */
-      if( ++singles == 4 ){
-         ++wt;
-         singles = 0;
+      if( ++r->singles == 4 ){
+         ++r->wt;
+         r->singles = 0;
       }
    }
-   else if( m_ch ) singles = 0;   
+   else if( m_ch ) r->singles = 0;   
  
    /* are we getting just e,i,s,h,5 ?   High speed limit reached.  Attempt to receive above 30 wpm */
   // if( m_ch > 0 && ( m_ch == 'S' || m_ch == 'H' || m_ch == 'I' || m_ch == '5' )) ++shi5;
@@ -2554,38 +3343,39 @@ static uint32_t tm;
    if( m_ch == 0 && force == 0 ){
      //if( ( slicer + wt ) < 10 ) ls = code_read_scan( slicer + wt -1 );
      //else ls = code_read_scan( slicer + wt -2 );
-     ls = code_read_scan( slicer + wt - ( slicer >> 2 ) );
-     m_ch = morse_lookup( ls, slicer );
+     ls = code_read_scan( r, slicer + r->wt - ( slicer >> 2 ) );
+     m_ch = morse_lookup( r, ls, slicer );
      if( m_ch > 64 ) m_ch += 32;       // lower case for this algorithm
      //if( m_ch ) --wt;     this doesn't seem to be a good idea
    }
  
    if( m_ch ){   /* found something so print it */
-      ++ch_count;
-      if( m_ch == 'E' || m_ch == 'I' ) ++eees;         // just noise ?
-      else eees = 0;
-      if( eees < 5 ){
-         decode_print(m_ch);
+      ++r->ch_count;
+      if( m_ch == 'E' || m_ch == 'I' ) ++r->eees;         // just noise ?
+      else r->eees = 0;
+      if( r->eees < 5 ){
+         out[n++] = m_ch;
          //if( TerminalMode ) Serial.write(m_ch), ++tcount;
       }
-      if( cread_buf[ls] > 3*slicer + farns ){   // check for word space
-        if( ch_count == 1 ) ++farns;            // single characters, no words printed
-        ch_count= 0;
-        decode_print(' ');
+      if( r->cread_buf[ls] > 3*slicer + r->farns ){   // check for word space
+        if( r->ch_count == 1 ) ++r->farns;            // single characters, no words printed
+        r->ch_count= 0;
+        out[n++] = ' ';
         //if( TerminalMode ) Serial.write(' '), ++tcount;
         //if( tcount > 55 ) tcount = 0, Serial.println();      // this is here so don't split words
       }
    }
      
    if( ls < 0 ) ls = 0;   // check if something wrong just in case  
-   shuffle_down( ls+1 );  
+   shuffle_down( r, ls+1 );  
 
    /* bounds for weight */
-   if( wt > slicer ) wt = slicer;
-   if( wt < -(slicer >> 1)) wt= -(slicer >> 1);
-   
-   if( ch_count > 10 ) --farns;
+   if( r->wt > slicer ) r->wt = slicer;
+   if( r->wt < -(slicer >> 1)) r->wt= -(slicer >> 1);
    
+   if( r->ch_count > 10 ) --r->farns;
+
+   return n;
 }
 
 
@@ -2634,6 +3424,132 @@ static int row = 4, col = 0;
 
 //  ***************   end of morse decode functions
 
+// ***************   CW skimmer, a read behind decoder on each channel of the Skimmer object   ******************
+#define SKIM_TEXT 18                // decoded text kept per channel, the OLED line length less the frequency
+
+struct SKIM_CH {
+   struct CW_READ rd;
+   int32_t noise;                   // floor, falls fast and rises slowly.  Levels are 4 bits fractional.
+   int32_t peak;                    // mark level, rises fast and decays in about half a second
+   uint32_t last;                   // millis of the last letter, the display lines go to the latest channels
+   char text[SKIM_TEXT+1];          // newest letter at the end
+};
+struct SKIM_CH skim[SKIM_CHANNELS];
+
+#ifdef USE_OLED
+  #define SKIM_LINES 5              // OLED rows 3 to 7
+#else
+  #define SKIM_LINES 3              // LCD rows 3 to 5
+#endif
+int skim_line[SKIM_LINES];          // channel shown on each line, -1 for none
+
+void skim_init(){
+int i, j;
+
+   for( i = 0; i < SKIM_CHANNELS; ++i ){
+      memset( &skim[i], 0, sizeof( struct SKIM_CH ));
+      skim[i].rd.dah_min = 12 * 10 / SKIM_FRAME_MS + 0.5;          // the decoder was tuned for 10ms counts
+      for( j = 0; j < 8; ++j ) skim[i].rd.dah_table[j] = 20 * 10 / SKIM_FRAME_MS + 0.5;
+      memset( skim[i].text, ' ', SKIM_TEXT );
+   }
+   for( i = 0; i < SKIM_LINES; ++i ) skim_line[i] = -1;
+}
+
+// run each channel's mark space tracker on the new frames and decode.  A channel marks when its level is half way
+// from the floor to the peak, the peak is 4 times the floor, and it is not smaller than its neighbors.  The neighbor
+// test keeps one signal from printing in the next bin over as well.
+void skim_process(){
+uint16_t mag[SKIM_CHANNELS];
+struct SKIM_CH *c;
+int32_t m;
+char out[2];
+int i, j, n, det;
+
+   if( transmitting || encoder_user != FREQ ){
+      while( Skimmer.available() ) Skimmer.read( mag );      // discard, don't decode stale frames later
+      return;
+   }
+   while( Skimmer.available() ){
+      Skimmer.read( mag );
+      for( i = 0; i < SKIM_CHANNELS; ++i ){
+         c = &skim[i];
+         m = mag[i] << 4;
+         if( m < c->noise ) c->noise -= ( c->noise - m ) >> 2;
+         else c->noise += (( m - c->noise ) >> 8 ) + 1;
+         if( m > c->peak ) c->peak = m;
+         else c->peak -= c->peak >> 6;
+
+         det = ( 2 * m > c->noise + c->peak && c->peak > 4 * c->noise );
+         if( i > 0 && mag[i] < mag[i-1] ) det = 0;
+         if( i < SKIM_CHANNELS - 1 && mag[i] < mag[i+1] ) det = 0;
+
+         det = cw_denoise( &c->rd, det );
+         if( cw_mark( &c->rd, det ) == 0 && c->rd.cread_indx < 15 ) continue;
+         n = code_decode( &c->rd, out );
+         for( j = 0; j < n; ++j ) skim_text( i, out[j] );
+      }
+   }
+}
+
+void skim_text( int ch, char c ){
+struct SKIM_CH *s;
+
+   s = &skim[ch];
+   if( c == ' ' && s->text[SKIM_TEXT-1] == ' ' ) return;     // no runs of spaces
+   memmove( s->text, s->text + 1, SKIM_TEXT - 1 );
+   s->text[SKIM_TEXT-1] = c;
+   s->last = millis();
+   skim_show( ch );
+}
+
+// put the channel on its display line, or take the line that has been quiet the longest
+void skim_show( int ch ){
+int i, ln;
+char buf[4];
+
+   ln = -1;
+   for( i = 0; i < SKIM_LINES; ++i ) if( skim_line[i] == ch ) ln = i;
+   if( ln < 0 ){
+      ln = 0;
+      for( i = 0; i < SKIM_LINES; ++i ){
+         if( skim_line[i] < 0 ){
+            ln = i;
+            break;
+         }
+         if( skim[skim_line[i]].last < skim[skim_line[ln]].last ) ln = i;
+      }
+      skim_line[ln] = ch;
+   }
+
+   i = ( SKIM_BIN0 + ch ) * SKIM_BIN_HZ / 100.0 + 0.5;              // audio tone in 100's of hz
+   buf[0] = '0' + i / 10;  buf[1] = '0' + i % 10;  buf[2] = ' ';  buf[3] = 0;
+   #ifdef USE_OLED
+     OLD.print( buf, 0, ROW3 + 8 * ln );
+     OLD.print( skim[ch].text, 3*6, ROW3 + 8 * ln );
+   #endif
+   #ifdef USE_LCD
+     if( ln < 3 ){
+        LCD.print( buf, 0, ROW3 + 8 * ln );
+        LCD.print( &skim[ch].text[SKIM_TEXT - 11], 3*6, ROW3 + 8 * ln );
+     }
+   #endif
+}
+
+// #K CAT command.  One line per channel that has decoded something, tone frequency and the latest text.
+void skim_report(){
+int i;
+
+   for( i = 0; i < SKIM_CHANNELS; ++i ){
+      if( skim[i].last == 0 ) continue;
+      stage_num( ( SKIM_BIN0 + i ) * SKIM_BIN_HZ + 0.5 );
+      stage(' ');
+      stage_str( skim[i].text );
+      stage('\r');
+   }
+}
+
+//  ***************   end of CW skimmer
+
 
 
 
@@ -2683,15 +3599,21 @@ struct MENU keyer_menu = {
 };
 
 struct MENU screen_menu = {
-    3,
+    4,
     "Decode Screen",
-    { "Info", "CW decod", "Scope" }
+    { "Info", "CW decod", "Scope", "Skimmer" }
+};
+
+struct MENU usb_io_menu = {
+    3,
+    "USB Audio",
+    { "Audio", "IQ rec", "IQ play" }
 };
 
 struct MENU main_menu = {
-  7,
+  8,
   "Top Menu",
-  { "Band", "Mode", "Filter", "Tx Src", "ATTN", "Keyer", "Decode" }
+  { "Band", "Mode", "Filter", "Tx Src", "ATTN", "Keyer", "Decode", "USB IQ" }
 };
 
 
@@ -2729,6 +3651,7 @@ int ret_val;
               case 4: active_menu = &attn_menu;  def_val = attn2; state = 5; break;
               case 5: active_menu = &keyer_menu; def_val = key_mode; state = 6; break;
               case 6: active_menu = &screen_menu; def_val = screen_user; state = 7; break;             
+              case 7: active_menu = &usb_io_menu; def_val = usb_io; state = 8; break;
             }
             def_val = top_menu2(def_val,active_menu, 0 );   // init a new submenu
          break;
@@ -2764,10 +3687,17 @@ int ret_val;
          break;
          case 7:
             screen_user = def_val;
-            if( screen_user != FFT_SCOPE ) Scope2.setmode( 0 );
-            else Scope2.setmode( 1 );                            // may be wrong mode for one pass
+            if( screen_user != FFT_SCOPE ) IQscope.setmode( 0 );
+            else IQscope.setmode( 1 );
+            if( screen_user == CW_SKIM ) skim_init();
+            Skimmer.setmode( screen_user == CW_SKIM );
             ret_val = state = 0;
          break;  
+         case 8:
+            usb_io = def_val;
+            set_usb_io();
+            ret_val = state = 0;
+         break;
          //default:  state = 0; ret_val = 0; break;  // temp
        }  // end switch
    }
@@ -2873,6 +3803,7 @@ char ts[2];
   
   if( ++count < 333 ) return;            // once a second for printing
   if( DEBUG_MP ) eer_test();             //  tx testing using sidetone
+  if( DSP_BENCH ) dsp_bench();           //  cycle counts of the custom audio objects
   count = 0;
 
   if( encoder_user != FREQ ) return;
@@ -2901,6 +3832,170 @@ char ts[2];
 
 
 
+// cycles in one 128 sample block, the budget for the whole audio library
+#define BLOCK_BUDGET  ( (uint32_t)( (float)F_CPU * AUDIO_BLOCK_SAMPLES / AUDIO_SAMPLE_RATE_EXACT ))
+
+// audio objects in the DSP_BENCH printout and the #P profile.  Our objects time their own update() with a DSP_TIMER.
+// Library objects have no cyc, their count is the library's cpu_cycles, kept in 64 cycle units.
+struct PROFILE {
+  const char *name;
+  AudioStream *obj;
+  struct DSP_CYCLES *cyc;
+};
+
+struct PROFILE dsp_objects[] = {
+  { "MagPhase", &MagPhase, &MagPhase.cycles },
+  { "IQscope", &IQscope, &IQscope.cycles },
+  { "Weaver", &Weaver, &Weaver.cycles },
+  { "agc", &agc, &agc.cycles },
+  { "QLow", &QLow, 0 },
+  { "NR", &NR, &NR.cycles },
+  { "Notch", &Notch, &Notch.cycles },
+  { "NB", &NB, &NB.cycles },
+  { "CWdet", &CWdet, &CWdet.cycles },
+  { "Skimmer", &Skimmer, &Skimmer.cycles }
+};
+#define NUM_PROFILE ( sizeof( dsp_objects ) / sizeof( struct PROFILE ))
+
+uint32_t obj_cycles( struct PROFILE *p ){
+
+   return ( p->cyc ) ? p->cyc->now : (uint32_t)p->obj->cpu_cycles << 6;
+}
+
+uint32_t obj_cycles_max( struct PROFILE *p ){
+
+   return ( p->cyc ) ? p->cyc->max : (uint32_t)p->obj->cpu_cycles_max << 6;
+}
+
+void obj_cycles_reset( struct PROFILE *p ){
+
+   if( p->cyc ) p->cyc->max = 0;
+   p->obj->processorUsageMaxReset();
+}
+
+uint32_t loop_cycles_max;            // longest time around loop(), one task and the scheduler
+uint32_t loop_count;
+
+void loop_profile(){
+uint32_t t, dt;
+
+   t = ARM_DWT_CYCCNT;
+   dt = t - loop_last;
+   if( loop_last && dt > loop_cycles_max ) loop_cycles_max = dt;
+   loop_last = t;
+   ++loop_count;
+}
+
+void bench_print( const char *name, uint32_t use, uint32_t use_max ){
+
+   Serial.print( name );      Serial.write(' ');
+   Serial.print( use );       Serial.write(' ');
+   Serial.print( use_max );   Serial.write(' ');
+}
+
+// print current and worst case cycles per block, and flag when the whole library has gone over the 3ms block budget
+void dsp_bench(){
+uint32_t budget;
+unsigned int i;
+
+   budget = BLOCK_BUDGET;
+   for( i = 0; i < NUM_PROFILE; ++i )
+      bench_print( dsp_objects[i].name, obj_cycles( &dsp_objects[i] ), obj_cycles_max( &dsp_objects[i] ));
+   bench_print( "All", (uint32_t)AudioStream::cpu_cycles_total << 6, (uint32_t)AudioStream::cpu_cycles_total_max << 6 );
+   Serial.print( budget );
+   if( ( (uint32_t)AudioStream::cpu_cycles_total_max << 6 ) > budget ) Serial.print(" OVER");
+   Serial.println();
+}
+
+void profile_line( const char *name, uint32_t a, uint32_t b, uint32_t c ){
+
+   stage_str( name );  stage(' ');
+   stage_num( a );     stage(' ');
+   stage_num( b );     stage(' ');
+   stage_num( c );     stage('\r');
+}
+
+// #P CAT command.  One line per item, all cycle counts at F_CPU.  Audio objects report the DWT cycles of their last
+// update(), worst case and the block budget.  EER reports the worst case time and the shortest and longest interrupt spacing.
+// I2Cbe is the display lane of the I2C arbiter, frame parts sent, gaps too short to use, and cycles per byte.
+void profile_report(){
+uint32_t emax, pmin, pmax;
+unsigned int i;
+
+   for( i = 0; i < NUM_PROFILE; ++i )
+      profile_line( dsp_objects[i].name, obj_cycles( &dsp_objects[i] ), obj_cycles_max( &dsp_objects[i] ), BLOCK_BUDGET );
+   profile_line( "All", (uint32_t)AudioStream::cpu_cycles_total << 6, (uint32_t)AudioStream::cpu_cycles_total_max << 6,
+                 BLOCK_BUDGET );
+   noInterrupts();
+   emax = eer_cycles_max;  pmin = eer_period_min;  pmax = eer_period_max;
+   interrupts();
+   if( pmin > pmax ) pmin = pmax;                 // no transmit yet
+   profile_line( "EER", emax, pmin, pmax );
+   profile_line( "Loop", loop_cycles_max, loop_count, F_CPU );
+   profile_line( "I2Cq", si5351.q_max, si5351.q_late, si5351.q_drops );
+   profile_line( "I2Cbe", i2be_parts, i2be_waits, i2_byte_cycles );
+   profile_line( "MPring", MagPhase.level(), MagPhase.underruns, MagPhase.overruns );
+}
+
+// #R CAT command, clear the worst case values
+void profile_reset(){
+unsigned int i;
+
+   for( i = 0; i < NUM_PROFILE; ++i ) obj_cycles_reset( &dsp_objects[i] );
+   AudioProcessorUsageMaxReset();
+   noInterrupts();
+   eer_cycles_max = eer_period_max = 0;
+   eer_period_min = 0xffffffff;
+   interrupts();
+   loop_cycles_max = loop_count = 0;
+   for( i = 0; i < NUM_TASKS; ++i ) tasks[i].runs = tasks[i].late = tasks[i].cycles_max = 0;
+   task_idle = 0;
+   si5351.queue_clear();
+   i2be_parts = i2be_waits = 0;
+   MagPhase.underruns = MagPhase.overruns = 0;
+   noInterrupts();
+   memset( (void *)i2_use, 0, sizeof( i2_use ));
+   interrupts();
+   i2_since = millis();
+   i2_tx_ms = 0;
+   if( transmitting ) i2_tx_start = millis();
+}
+
+// #T CAT command.  Runs, late starts and the longest run in cycles for each task, then the passes that found nothing
+// to do since #R.
+void task_report(){
+unsigned int i;
+
+   for( i = 0; i < NUM_TASKS; ++i ) profile_line( tasks[i].name, tasks[i].runs, tasks[i].late, tasks[i].cycles_max );
+   profile_line( "Idle", task_idle, loop_count, F_CPU );
+}
+
+// #I CAT command.  Frames, bytes and bus microseconds for each feature since #R.  Time is the ms since #R, ms of
+// that spent transmitting, and the clock.  Busy is EER bus time per 1000 of the transmit time, and all bus time per
+// 1000 of the whole time, for the tx rate and mode in use.  1000 is the ceiling.
+void i2_report(){
+const char *names[I2F_N] = { "qsy", "band", "EER", "disp", "other" };
+struct I2_USE u[I2F_N];
+uint32_t clk, tx_ms, ms, all;
+int i;
+
+   noInterrupts();
+   for( i = 0; i < I2F_N; ++i ) u[i].frames = i2_use[i].frames, u[i].bytes = i2_use[i].bytes, u[i].bits = i2_use[i].bits;
+   interrupts();
+   clk = Wire.getClock();
+   ms = millis() - i2_since;
+   tx_ms = i2_tx_ms + ( transmitting ? millis() - i2_tx_start : 0 );
+   all = 0;
+   for( i = 0; i < I2F_N; ++i ){
+      profile_line( names[i], u[i].frames, u[i].bytes, (uint64_t)u[i].bits * 1000000 / clk );
+      all += (uint64_t)u[i].bits * 1000000 / clk;
+   }
+   profile_line( "Time", ms, tx_ms, clk );
+   profile_line( "Rate", tx_rate, mode, eer_ua );
+   profile_line( "Busy", tx_ms ? (uint64_t)u[I2F_EER].bits * 1000000 / clk / tx_ms : 0, ms ? all / ms : 0, 1000 );
+}
+
+
 #ifdef NOWAY
 /***********************   saving some old code   */
 